@@ -17,12 +17,37 @@ public class LuaRuntime : ModuleRules
 		
         PrivateIncludePaths.AddRange(
             new string[] {
-                // Lua slim sources (compiled into this module)
+                // Lua slim sources (compiled into this module); the only Lua include path, so every header
+                // (including ljumptab.h) comes from the vendored copy
                 System.IO.Path.Combine(ModuleDirectory, "Private", "ThirdParty", "lua_slim", "src"),
-                // Full Lua headers (do not compile sources here)
-                System.IO.Path.Combine(ModuleDirectory, "..", "..", "ThirdParty", "lua-5.4.7", "src"),
             }
         );
+
+        // The interpreter loop dominates script cost: optimize this module for speed in every configuration,
+        // including Debug and DebugGame editors
+        OptimizeCode = CodeOptimization.Always;
+        OptimizationLevel = OptimizationMode.Speed;
+
+        // Computed-goto dispatch (ljumptab.h) on Clang and GCC. Set explicitly: lvm.c only detects it through
+        // __GNUC__, which clang-cl does not define. MSVC has no computed goto and keeps the switch.
+        bool bUseJumpTable = Target.Platform != UnrealTargetPlatform.Win64 || Target.WindowsPlatform.Compiler.IsClang();
+        PrivateDefinitions.Add("LUA_USE_JUMPTABLE=" + (bUseJumpTable ? "1" : "0"));
+
+        // Key for the HMAC that cooked script bytecode is signed with (ULuaScript). Without one, cooked bytecode is
+        // never trusted and scripts always compile from source. Keep it out of source control, e.g. set it on the
+        // build machine only.
+        string BytecodeKey = System.Environment.GetEnvironmentVariable("LUARUNTIME_BYTECODE_KEY");
+        if (!string.IsNullOrEmpty(BytecodeKey))
+        {
+            foreach (char C in BytecodeKey)
+            {
+                if (!char.IsLetterOrDigit(C))
+                {
+                    throw new BuildException("LUARUNTIME_BYTECODE_KEY may only contain letters and digits");
+                }
+            }
+            PrivateDefinitions.Add("LUARUNTIME_BYTECODE_KEY=\"" + BytecodeKey + "\"");
+        }
 			
 		
 		PublicDependencyModuleNames.AddRange(
@@ -0,0 +1,687 @@
+#include "LuaAllocator.h"
+#include "LuaSandbox.h"
+
+namespace {
+
+static constexpr uint32 GSizeClassBytes[FLuaAllocator::NumSizeClasses] = { 8, 16, 24, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256 };
+
+// Indexed by (Size + 7) / 8 for Size in 1..MaxSmallSize
+static constexpr uint8 GSizeClassLookup[33] = {
+    0,
+    0, 1, 2, 3, 4, 4, 5, 5,
+    6, 6, 7, 7, 8, 8, 9, 9,
+    10, 10, 10, 10, 11, 11, 11, 11,
+    12, 12, 12, 12, 13, 13, 13, 13
+};
+
+// Blocks start after the slab header, keeping Lua's required max alignment
+static constexpr SIZE_T GSlabHeaderSize = 16;
+
+// Large arena blocks are rounded to this; every arena block stays 8-byte aligned
+static constexpr SIZE_T GArenaLargeGranularity = 16;
+
+// A split-off remainder must still be a valid large block
+static constexpr SIZE_T GArenaMinSplit = FLuaAllocator::MaxSmallSize + GArenaLargeGranularity;
+
+// Single-writer counter bump: a plain load and store instead of a locked read-modify-write
+static void IncrementCounter(std::atomic<int64>& Counter)
+{
+    Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+}
+
+FLuaAllocator::FLuaAllocator(int64 InLimitBytes, bool bInUseSmallObjectPool, FLuaMemoryCounters& InCounters)
+    : LimitBytes(InLimitBytes)
+    , Counters(InCounters)
+    , bUseSmallObjectPool(bInUseSmallObjectPool)
+{
+    Counters.LimitBytes.store(LimitBytes, std::memory_order_relaxed);
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        Classes[i].BlockSize = GSizeClassBytes[i];
+    }
+}
+
+FLuaAllocator* FLuaAllocator::CreateArena(int64 InLimitBytes, int64 ArenaBytes, FLuaMemoryCounters& InCounters)
+{
+    FLuaAllocator* Allocator = new FLuaAllocator(InLimitBytes, true, InCounters);
+    const SIZE_T Size = Align((SIZE_T)ArenaBytes, GArenaLargeGranularity);
+    Allocator->ArenaBase = static_cast<uint8*>(FMemory::Malloc(Size, GArenaLargeGranularity));
+    Allocator->ArenaTop = Allocator->ArenaBase;
+    Allocator->ArenaEnd = Allocator->ArenaBase ? Allocator->ArenaBase + Size : nullptr;
+    return Allocator;
+}
+
+FLuaAllocator::~FLuaAllocator()
+{
+    if (ArenaBase)
+    {
+        // One free for the whole heap, whatever Lua left in it
+        FMemory::Free(ArenaBase);
+    }
+
+    // lua_close has freed every object by now; the slabs themselves are still ours
+    while (Slabs)
+    {
+        FSlab* Next = Slabs->Next;
+        FMemory::Free(Slabs);
+        Slabs = Next;
+    }
+}
+
+int32 FLuaAllocator::GetSizeClass(size_t Size)
+{
+    return Size <= MaxSmallSize ? GSizeClassLookup[(Size + 7) >> 3] : INDEX_NONE;
+}
+
+int32 FLuaAllocator::GetBlocksPerSlab(uint32 BlockSize)
+{
+    return (int32)((SlabSize - GSlabHeaderSize) / BlockSize);
+}
+
+void* FLuaAllocator::LuaAlloc(void* UserData, void* Ptr, size_t OldSize, size_t NewSize)
+{
+    return static_cast<FLuaAllocator*>(UserData)->Realloc(Ptr, OldSize, NewSize);
+}
+
+void* FLuaAllocator::Realloc(void* Ptr, size_t OldSize, size_t NewSize)
+{
+    // For new objects Lua passes the object type in OldSize, not a size
+    if (Ptr == nullptr)
+    {
+        OldSize = 0;
+    }
+
+    const int64 Delta = (int64)NewSize - (int64)OldSize;
+    if (Delta > 0 && LimitBytes > 0 && UsedBytes + Delta > LimitBytes)
+    {
+        // Allocation would exceed the cap (shrinking never fails, as Lua expects)
+        IncrementCounter(Counters.NumFailedAllocations);
+        return nullptr;
+    }
+
+    const int32 OldClass = (Ptr && bUseSmallObjectPool) ? GetSizeClass(OldSize) : INDEX_NONE;
+
+    if (NewSize == 0)
+    {
+        if (Ptr)
+        {
+            if (OldClass != INDEX_NONE)
+            {
+                FreeSmall(Ptr, OldClass, OldSize);
+            }
+            else
+            {
+                FreeLarge(Ptr, OldSize);
+            }
+        }
+        UsedBytes += Delta;
+        PublishUsedBytes();
+        return nullptr;
+    }
+
+    const int32 NewClass = bUseSmallObjectPool ? GetSizeClass(NewSize) : INDEX_NONE;
+    void* NewPtr = nullptr;
+
+    if (Ptr && OldClass != INDEX_NONE && OldClass == NewClass)
+    {
+        // Still fits the same block
+        Classes[OldClass].RequestedBytes += Delta;
+        NewPtr = Ptr;
+    }
+    else if (Ptr && OldClass == INDEX_NONE && NewClass == INDEX_NONE)
+    {
+        NewPtr = ReallocLarge(Ptr, OldSize, NewSize);
+    }
+    else
+    {
+        NewPtr = NewClass != INDEX_NONE ? AllocSmall(NewClass, NewSize) : AllocLarge(NewSize);
+        if (NewPtr && Ptr)
+        {
+            FMemory::Memcpy(NewPtr, Ptr, FMath::Min(OldSize, NewSize));
+            if (OldClass != INDEX_NONE)
+            {
+                FreeSmall(Ptr, OldClass, OldSize);
+            }
+            else
+            {
+                FreeLarge(Ptr, OldSize);
+            }
+        }
+        else if (Ptr && NewSize <= OldSize && ArenaBase)
+        {
+            // Shrinking must not fail even with the arena full (outside an arena FMemory reports running out itself)
+            NewPtr = ArenaShrinkInPlace(Ptr, OldClass, OldSize, NewClass, NewSize);
+        }
+    }
+
+    if (NewPtr)
+    {
+        UsedBytes += Delta;
+        PublishUsedBytes();
+        if (!Ptr)
+        {
+            IncrementCounter(Counters.NumAllocations);
+        }
+    }
+    else
+    {
+        IncrementCounter(Counters.NumFailedAllocations);
+    }
+    return NewPtr;
+}
+
+void FLuaAllocator::PublishUsedBytes()
+{
+    Counters.UsedBytes.store(UsedBytes, std::memory_order_relaxed);
+    if (UsedBytes > PeakBytes)
+    {
+        PeakBytes = UsedBytes;
+        Counters.PeakBytes.store(PeakBytes, std::memory_order_relaxed);
+    }
+}
+
+void FLuaAllocator::SetLimitBytes(int64 InLimitBytes)
+{
+    LimitBytes = InLimitBytes;
+    Counters.LimitBytes.store(LimitBytes, std::memory_order_relaxed);
+}
+
+void* FLuaAllocator::AllocSmall(int32 ClassIndex, size_t Size)
+{
+    FSizeClass& Class = Classes[ClassIndex];
+
+    void* Block = Class.FreeList;
+    if (Block)
+    {
+        Class.FreeList = *static_cast<void**>(Block);
+    }
+    else if (ArenaBase)
+    {
+        Block = ArenaAllocSmall(ClassIndex);
+        if (!Block)
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        if (Class.Bump == Class.End && !AddSlab(ClassIndex))
+        {
+            return nullptr;
+        }
+        Block = Class.Bump;
+        Class.Bump += Class.BlockSize;
+    }
+
+    ++Class.BlocksInUse;
+    ++Class.TotalAllocations;
+    Class.RequestedBytes += (int64)Size;
+    return Block;
+}
+
+void FLuaAllocator::FreeSmall(void* Ptr, int32 ClassIndex, size_t Size)
+{
+    FSizeClass& Class = Classes[ClassIndex];
+    *static_cast<void**>(Ptr) = Class.FreeList;
+    Class.FreeList = Ptr;
+    --Class.BlocksInUse;
+    Class.RequestedBytes -= (int64)Size;
+}
+
+void* FLuaAllocator::AllocLarge(size_t Size)
+{
+    void* Ptr = ArenaBase ? ArenaAllocLarge(Size) : FMemory::Malloc(Size);
+    if (Ptr)
+    {
+        LargeBytes += (int64)Size;
+        ++NumLargeBlocks;
+    }
+    return Ptr;
+}
+
+void* FLuaAllocator::ReallocLarge(void* Ptr, size_t OldSize, size_t NewSize)
+{
+    if (!ArenaBase)
+    {
+        void* NewPtr = FMemory::Realloc(Ptr, NewSize);
+        if (NewPtr)
+        {
+            LargeBytes += (int64)NewSize - (int64)OldSize;
+        }
+        return NewPtr;
+    }
+
+    const SIZE_T OldRounded = Align(OldSize, GArenaLargeGranularity);
+    const SIZE_T NewRounded = Align(NewSize, GArenaLargeGranularity);
+    uint8* Block = static_cast<uint8*>(Ptr);
+
+    // Resize in place when the rounded size is unchanged or the block is the last one carved
+    const bool bAtTop = Block + OldRounded == ArenaTop;
+    if (NewRounded == OldRounded || (bAtTop && Block + NewRounded <= ArenaEnd))
+    {
+        if (bAtTop)
+        {
+            ArenaTop = Block + NewRounded;
+        }
+        LargeBytes += (int64)NewSize - (int64)OldSize;
+        return Ptr;
+    }
+
+    if (NewRounded < OldRounded)
+    {
+        // Shrinking must not fail: keep the block and give back the tail
+        ArenaFreeRun(Block + NewRounded, OldRounded - NewRounded);
+        LargeBytes += (int64)NewSize - (int64)OldSize;
+        return Ptr;
+    }
+
+    void* NewPtr = AllocLarge(NewSize);
+    if (NewPtr)
+    {
+        FMemory::Memcpy(NewPtr, Ptr, FMath::Min(OldSize, NewSize));
+        FreeLarge(Ptr, OldSize);
+    }
+    return NewPtr;
+}
+
+void FLuaAllocator::FreeLarge(void* Ptr, size_t Size)
+{
+    if (ArenaBase)
+    {
+        ArenaFreeLarge(Ptr, Size);
+    }
+    else
+    {
+        FMemory::Free(Ptr);
+    }
+    LargeBytes -= (int64)Size;
+    --NumLargeBlocks;
+}
+
+void* FLuaAllocator::ArenaAlloc(SIZE_T Size)
+{
+    if ((SIZE_T)(ArenaEnd - ArenaTop) < Size)
+    {
+        return nullptr;
+    }
+    void* Block = ArenaTop;
+    ArenaTop += Size;
+    return Block;
+}
+
+void* FLuaAllocator::ArenaAllocSmall(int32 ClassIndex)
+{
+    // Refill the class with a whole slab-sized chunk so small objects stay packed together
+    // instead of pinning scattered spots that large blocks could have used
+    FSizeClass& Class = Classes[ClassIndex];
+    uint8* Chunk = static_cast<uint8*>(ArenaAllocLarge(SlabSize));
+    SIZE_T ChunkSize = SlabSize;
+    if (!Chunk)
+    {
+        // Nearly full: coalescing may have produced blocks of this class, else settle for a single block
+        if (void* Block = Class.FreeList)
+        {
+            Class.FreeList = *static_cast<void**>(Block);
+            return Block;
+        }
+        Chunk = static_cast<uint8*>(ArenaAllocLarge(Class.BlockSize));
+        ChunkSize = Align((SIZE_T)Class.BlockSize, GArenaLargeGranularity);
+        if (!Chunk)
+        {
+            return nullptr;
+        }
+    }
+
+    const SIZE_T NumBlocks = ChunkSize / Class.BlockSize;
+    for (SIZE_T i = NumBlocks; i > 1; --i)
+    {
+        void* Block = Chunk + (i - 1) * Class.BlockSize;
+        *static_cast<void**>(Block) = Class.FreeList;
+        Class.FreeList = Block;
+    }
+    const SIZE_T Used = NumBlocks * Class.BlockSize;
+    if (Used < ChunkSize)
+    {
+        ArenaFreeRun(Chunk + Used, ChunkSize - Used);
+    }
+    return Chunk;
+}
+
+void* FLuaAllocator::ArenaAllocLarge(SIZE_T Size)
+{
+    const SIZE_T Rounded = Align(Size, GArenaLargeGranularity);
+    if (void* Block = ArenaTakeFromFreeRuns(Rounded))
+    {
+        return Block;
+    }
+    if (void* Block = ArenaAlloc(Rounded))
+    {
+        return Block;
+    }
+    if (!ArenaCoalesce())
+    {
+        return nullptr;
+    }
+    if (void* Block = ArenaTakeFromFreeRuns(Rounded))
+    {
+        return Block;
+    }
+    return ArenaAlloc(Rounded);
+}
+
+void* FLuaAllocator::ArenaTakeFromFreeRuns(SIZE_T Size)
+{
+    // Best fit keeps large runs intact for large requests; whatever is left over goes back as a free run
+    FArenaFreeBlock** BestLink = nullptr;
+    for (FArenaFreeBlock** Link = &ArenaFreeList; *Link; Link = &(*Link)->Next)
+    {
+        if ((*Link)->Size >= Size && (!BestLink || (*Link)->Size < (*BestLink)->Size))
+        {
+            BestLink = Link;
+            if ((*Link)->Size == Size)
+            {
+                break;
+            }
+        }
+    }
+    if (!BestLink)
+    {
+        return nullptr;
+    }
+
+    FArenaFreeBlock* Free = *BestLink;
+    *BestLink = Free->Next;
+    const SIZE_T Rest = Free->Size - Size;
+    if (Rest > 0)
+    {
+        ArenaFreeRun(reinterpret_cast<uint8*>(Free) + Size, Rest);
+    }
+    return Free;
+}
+
+void FLuaAllocator::ArenaFreeLarge(void* Ptr, SIZE_T Size)
+{
+    const SIZE_T Rounded = Align(Size, GArenaLargeGranularity);
+    uint8* Block = static_cast<uint8*>(Ptr);
+    if (Block + Rounded == ArenaTop)
+    {
+        ArenaTop = Block;
+        return;
+    }
+    ArenaFreeRun(Block, Rounded);
+}
+
+void FLuaAllocator::ArenaFreeRun(uint8* Run, SIZE_T Size)
+{
+    if (Size >= GArenaMinSplit)
+    {
+        FArenaFreeBlock* Free = reinterpret_cast<FArenaFreeBlock*>(Run);
+        Free->Size = Size;
+        Free->Next = ArenaFreeList;
+        ArenaFreeList = Free;
+        return;
+    }
+
+    // Too small for the run list: cut it into size-class blocks (every size is a multiple of the 8-byte class)
+    while (Size > 0)
+    {
+        int32 ClassIndex = NumSizeClasses - 1;
+        while (Classes[ClassIndex].BlockSize > Size)
+        {
+            --ClassIndex;
+        }
+        FSizeClass& Class = Classes[ClassIndex];
+        *reinterpret_cast<void**>(Run) = Class.FreeList;
+        Class.FreeList = Run;
+        Run += Class.BlockSize;
+        Size -= Class.BlockSize;
+    }
+}
+
+// A shrink that moves to a smaller size class keeps its block: the head becomes a block of the new class and the
+// rest goes back to the arena, so a later free with the new size finds the block where it expects
+void* FLuaAllocator::ArenaShrinkInPlace(void* Ptr, int32 OldClass, size_t OldSize, int32 NewClass, size_t NewSize)
+{
+    SIZE_T OldBlockSize = 0;
+    if (OldClass != INDEX_NONE)
+    {
+        FSizeClass& Old = Classes[OldClass];
+        OldBlockSize = Old.BlockSize;
+        --Old.BlocksInUse;
+        Old.RequestedBytes -= (int64)OldSize;
+    }
+    else
+    {
+        OldBlockSize = Align(OldSize, GArenaLargeGranularity);
+        LargeBytes -= (int64)OldSize;
+        --NumLargeBlocks;
+    }
+
+    // Only reached for a smaller size class: same-class and large-to-large shrinks never allocate
+    FSizeClass& New = Classes[NewClass];
+    if (OldBlockSize > New.BlockSize)
+    {
+        ArenaFreeRun(static_cast<uint8*>(Ptr) + New.BlockSize, OldBlockSize - New.BlockSize);
+    }
+    ++New.BlocksInUse;
+    ++New.TotalAllocations;
+    New.RequestedBytes += (int64)NewSize;
+    return Ptr;
+}
+
+bool FLuaAllocator::ArenaCoalesce()
+{
+    struct FRun
+    {
+        uint8* Start;
+        SIZE_T Size;
+    };
+
+    // Gather every free block the arena knows about, whatever list it is on
+    TArray<FRun> Runs;
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        for (void* Block = Classes[i].FreeList; Block; Block = *static_cast<void**>(Block))
+        {
+            Runs.Add({ static_cast<uint8*>(Block), Classes[i].BlockSize });
+        }
+    }
+    for (FArenaFreeBlock* Free = ArenaFreeList; Free; Free = Free->Next)
+    {
+        Runs.Add({ reinterpret_cast<uint8*>(Free), Free->Size });
+    }
+    if (Runs.Num() < 2)
+    {
+        return false;
+    }
+
+    Runs.Sort([](const FRun& A, const FRun& B) { return A.Start < B.Start; });
+
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        Classes[i].FreeList = nullptr;
+    }
+    ArenaFreeList = nullptr;
+
+    // Merge neighbours and rebuild the lists; a run touching the top just lowers it
+    bool bMerged = false;
+    int32 i = 0;
+    while (i < Runs.Num())
+    {
+        uint8* Start = Runs[i].Start;
+        SIZE_T Size = Runs[i].Size;
+        int32 j = i + 1;
+        for (; j < Runs.Num() && Runs[j].Start == Start + Size; ++j)
+        {
+            Size += Runs[j].Size;
+            bMerged = true;
+        }
+
+        if (Start + Size == ArenaTop)
+        {
+            ArenaTop = Start;
+            bMerged = true;
+        }
+        else
+        {
+            ArenaFreeRun(Start, Size);
+        }
+        i = j;
+    }
+    return bMerged;
+}
+
+bool FLuaAllocator::AddSlab(int32 ClassIndex)
+{
+    static_assert(sizeof(FSlab) <= GSlabHeaderSize, "Slab header must fit before the first block");
+
+    void* Memory = FMemory::Malloc(SlabSize);
+    if (!Memory)
+    {
+        return false;
+    }
+
+    FSlab* Slab = new (Memory) FSlab();
+    Slab->ClassIndex = ClassIndex;
+    Slab->Next = Slabs;
+    Slabs = Slab;
+
+    FSizeClass& Class = Classes[ClassIndex];
+    Class.Bump = static_cast<uint8*>(Memory) + GSlabHeaderSize;
+    Class.End = Class.Bump + (SIZE_T)GetBlocksPerSlab(Class.BlockSize) * Class.BlockSize;
+    ++Class.NumSlabs;
+    return true;
+}
+
+int64 FLuaAllocator::Trim()
+{
+    TArray<FSlab*> Sorted;
+    for (FSlab* Slab = Slabs; Slab; Slab = Slab->Next)
+    {
+        Slab->FreeBlocks = 0;
+        Sorted.Add(Slab);
+    }
+    if (Sorted.Num() == 0)
+    {
+        return 0;
+    }
+    Sorted.Sort([](const FSlab& A, const FSlab& B) { return &A < &B; });
+
+    auto FindSlab = [&Sorted](const void* Block) -> FSlab*
+    {
+        // Last slab starting at or below Block
+        int32 Lo = 0, Hi = Sorted.Num() - 1;
+        while (Lo < Hi)
+        {
+            const int32 Mid = (Lo + Hi + 1) / 2;
+            if ((const void*)Sorted[Mid] <= Block) Lo = Mid; else Hi = Mid - 1;
+        }
+        return Sorted[Lo];
+    };
+
+    // Count free blocks per slab: free-list entries plus the uncarved tail of the newest slab
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        FSizeClass& Class = Classes[i];
+        for (void* Block = Class.FreeList; Block; Block = *static_cast<void**>(Block))
+        {
+            ++FindSlab(Block)->FreeBlocks;
+        }
+        if (Class.Bump < Class.End)
+        {
+            FindSlab(Class.Bump)->FreeBlocks += (int32)((Class.End - Class.Bump) / Class.BlockSize);
+        }
+    }
+
+    auto IsEmpty = [](const FSlab* Slab, uint32 BlockSize) { return Slab->FreeBlocks == GetBlocksPerSlab(BlockSize); };
+
+    // Drop blocks of empty slabs from the free lists
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        FSizeClass& Class = Classes[i];
+        void** Link = &Class.FreeList;
+        while (*Link)
+        {
+            if (IsEmpty(FindSlab(*Link), Class.BlockSize))
+            {
+                *Link = *static_cast<void**>(*Link);
+            }
+            else
+            {
+                Link = static_cast<void**>(*Link);
+            }
+        }
+        if (Class.Bump < Class.End && IsEmpty(FindSlab(Class.Bump), Class.BlockSize))
+        {
+            Class.Bump = Class.End = nullptr;
+        }
+    }
+
+    int64 Released = 0;
+    FSlab** Link = &Slabs;
+    while (*Link)
+    {
+        FSlab* Slab = *Link;
+        if (IsEmpty(Slab, Classes[Slab->ClassIndex].BlockSize))
+        {
+            *Link = Slab->Next;
+            --Classes[Slab->ClassIndex].NumSlabs;
+            FMemory::Free(Slab);
+            Released += SlabSize;
+        }
+        else
+        {
+            Link = &Slab->Next;
+        }
+    }
+    return Released;
+}
+
+void FLuaAllocator::GetStats(FLuaAllocatorStats& OutStats) const
+{
+    OutStats = FLuaAllocatorStats();
+    OutStats.bSmallObjectPool = bUseSmallObjectPool;
+    OutStats.UsedBytes = UsedBytes;
+    OutStats.LimitBytes = LimitBytes;
+    OutStats.LargeBytes = LargeBytes;
+    OutStats.NumLargeBlocks = NumLargeBlocks;
+    OutStats.bArena = ArenaBase != nullptr;
+    OutStats.ArenaBytes = ArenaEnd - ArenaBase;
+    OutStats.ArenaTopBytes = ArenaTop - ArenaBase;
+
+    int64 Requested = 0;
+    for (int32 i = 0; i < NumSizeClasses; ++i)
+    {
+        const FSizeClass& Class = Classes[i];
+        const int32 Capacity = GetBlocksPerSlab(Class.BlockSize);
+
+        FLuaSizeClassStats& ClassStats = OutStats.SizeClasses.AddDefaulted_GetRef();
+        ClassStats.BlockSize = (int32)Class.BlockSize;
+        ClassStats.NumSlabs = Class.NumSlabs;
+        ClassStats.BlocksInUse = Class.BlocksInUse;
+        if (ArenaBase)
+        {
+            for (void* Block = Class.FreeList; Block; Block = *static_cast<void**>(Block))
+            {
+                ++ClassStats.BlocksFree;
+            }
+        }
+        else
+        {
+            ClassStats.BlocksFree = (int64)Class.NumSlabs * Capacity - Class.BlocksInUse;
+        }
+        ClassStats.TotalAllocations = Class.TotalAllocations;
+
+        OutStats.SlabBytes += (int64)Class.NumSlabs * SlabSize;
+        OutStats.SmallBlockBytes += Class.BlocksInUse * Class.BlockSize;
+        Requested += Class.RequestedBytes;
+    }
+    OutStats.SmallRequestedBytes = Requested;
+
+    // Share of reserved memory not holding requested bytes (rounding waste + free blocks + headers)
+    const int64 Reserved = ArenaBase ? OutStats.ArenaTopBytes : OutStats.SlabBytes;
+    const int64 Held = ArenaBase ? UsedBytes : Requested;
+    OutStats.Fragmentation = Reserved > 0 ? (float)FMath::Max(0.0, 1.0 - (double)Held / (double)Reserved) : 0.0f;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+struct FLuaAllocatorStats;
+
+/**
+ * Memory telemetry of one sandbox, readable from any thread without locks.
+ * Only the thread running the sandbox writes (relaxed load and store, no read-modify-write on the allocation path).
+ * Owned by the sandbox so readers never see it freed when the state is closed or recreated.
+ */
+struct FLuaMemoryCounters
+{
+    std::atomic<int64> UsedBytes{0};
+    std::atomic<int64> PeakBytes{0};
+    std::atomic<int64> LimitBytes{0};
+    std::atomic<int64> NumAllocations{0};
+    std::atomic<int64> NumFailedAllocations{0};
+    std::atomic<int64> GCDebtBytes{0};
+
+    void Reset()
+    {
+        UsedBytes.store(0, std::memory_order_relaxed);
+        PeakBytes.store(0, std::memory_order_relaxed);
+        NumAllocations.store(0, std::memory_order_relaxed);
+        NumFailedAllocations.store(0, std::memory_order_relaxed);
+        GCDebtBytes.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Per-sandbox allocator handed to lua_newstate.
+ * Requests up to MaxSmallSize bytes are served from size-class slabs owned by this sandbox, so the many tiny
+ * strings, tables, nodes and closures Lua churns through never reach the global allocator (and need no lock:
+ * a sandbox only runs on one thread at a time). Freed small blocks go on a per-class free list; slabs are
+ * returned by Trim (called when a pooled sandbox is reset) or when the sandbox closes. Larger blocks go to FMemory.
+ * LimitBytes caps the bytes Lua asked for, exactly like the previous counting allocator.
+ */
+class FLuaAllocator
+{
+public:
+    static constexpr int32 NumSizeClasses = 14;
+    static constexpr SIZE_T MaxSmallSize = 256;
+    static constexpr SIZE_T SlabSize = 4 * 1024;
+
+    FLuaAllocator(int64 InLimitBytes, bool bInUseSmallObjectPool, FLuaMemoryCounters& InCounters);
+
+    /**
+     * Arena mode: the whole heap lives in one preallocated block of ArenaBytes.
+     * Small blocks and large blocks are bump-allocated from it and recycled through free lists, which are
+     * coalesced when the arena runs out; the limit still applies to requested bytes. Destroying the allocator releases everything at once, so the owner
+     * may skip lua_close (finalizers do not run).
+     */
+    static FLuaAllocator* CreateArena(int64 InLimitBytes, int64 ArenaBytes, FLuaMemoryCounters& InCounters);
+    ~FLuaAllocator();
+
+    FLuaAllocator(const FLuaAllocator&) = delete;
+    FLuaAllocator& operator=(const FLuaAllocator&) = delete;
+
+    /** lua_Alloc entry point; UserData is the FLuaAllocator. */
+    static void* LuaAlloc(void* UserData, void* Ptr, size_t OldSize, size_t NewSize);
+
+    void GetStats(FLuaAllocatorStats& OutStats) const;
+
+    /** Return slabs whose blocks are all free to FMemory. Returns the number of bytes released. */
+    int64 Trim();
+
+    bool IsArena() const { return ArenaBase != nullptr; }
+
+    /** Arena size to reserve for a limit, leaving headroom for size-class rounding and free-list fragmentation. */
+    static int64 GetArenaBytesForLimit(int64 LimitBytes) { return LimitBytes + LimitBytes / 4 + 64 * 1024; }
+
+    void SetLimitBytes(int64 InLimitBytes);
+
+private:
+    struct FSlab
+    {
+        FSlab* Next = nullptr;
+        int32 ClassIndex = 0;
+
+        /** Scratch counter used by Trim. */
+        int32 FreeBlocks = 0;
+    };
+
+    struct FSizeClass
+    {
+        uint32 BlockSize = 0;
+        int32 NumSlabs = 0;
+        int64 BlocksInUse = 0;
+        int64 RequestedBytes = 0;
+        int64 TotalAllocations = 0;
+
+        /** Intrusive list of freed blocks. */
+        void* FreeList = nullptr;
+
+        /** Uncarved remainder of the newest slab. */
+        uint8* Bump = nullptr;
+        uint8* End = nullptr;
+    };
+
+    void* Realloc(void* Ptr, size_t OldSize, size_t NewSize);
+    void PublishUsedBytes();
+    void* AllocSmall(int32 ClassIndex, size_t Size);
+    void FreeSmall(void* Ptr, int32 ClassIndex, size_t Size);
+    void* AllocLarge(size_t Size);
+    void* ReallocLarge(void* Ptr, size_t OldSize, size_t NewSize);
+    void FreeLarge(void* Ptr, size_t Size);
+    bool AddSlab(int32 ClassIndex);
+
+    void* ArenaAlloc(SIZE_T Size);
+    void* ArenaAllocSmall(int32 ClassIndex);
+    void* ArenaAllocLarge(SIZE_T Size);
+    void* ArenaTakeFromFreeRuns(SIZE_T Size);
+    void ArenaFreeLarge(void* Ptr, SIZE_T Size);
+    void ArenaFreeRun(uint8* Run, SIZE_T Size);
+    bool ArenaCoalesce();
+    void* ArenaShrinkInPlace(void* Ptr, int32 OldClass, size_t OldSize, int32 NewClass, size_t NewSize);
+
+    /** Freed large arena block (stored inside the block itself). */
+    struct FArenaFreeBlock
+    {
+        FArenaFreeBlock* Next = nullptr;
+        SIZE_T Size = 0;
+    };
+
+    static int32 GetSizeClass(size_t Size);
+    static int32 GetBlocksPerSlab(uint32 BlockSize);
+
+    int64 LimitBytes = 0;
+    int64 UsedBytes = 0;
+    int64 PeakBytes = 0;
+    FLuaMemoryCounters& Counters;
+
+    FSizeClass Classes[NumSizeClasses];
+    FSlab* Slabs = nullptr;
+    int64 LargeBytes = 0;
+    int32 NumLargeBlocks = 0;
+    bool bUseSmallObjectPool = true;
+
+    uint8* ArenaBase = nullptr;
+    uint8* ArenaTop = nullptr;
+    uint8* ArenaEnd = nullptr;
+    FArenaFreeBlock* ArenaFreeList = nullptr;
+};
@@ -0,0 +1,373 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/Package.h"
+#include "LuaRuntime.h"
+#include "LuaSandbox.h"
+#include "LuaValue.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+}
+
+namespace {
+
+// Builds a table shaped like typical gameplay data: N records with nested fields.
+static FString MakeMarshalBenchScript(int32 NumEntries)
+{
+    return FString::Printf(TEXT(
+        "local t = {}\n"
+        "for i = 1, %d do\n"
+        "  t[i] = { id = i, name = 'entry' .. i, alive = (i %% 2 == 0), pos = { x = i * 0.5, y = -i, z = 0 } }\n"
+        "end\n"
+        "return t\n"), NumEntries);
+}
+
+static void RunMarshalBenchmark(const TArray<FString>& Args)
+{
+    const int32 NumEntries = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+
+    ULuaSandbox* Sandbox = NewObject<ULuaSandbox>(GetTransientPackage());
+    Sandbox->Initialize(64 * 1024);
+
+    const FString Code = MakeMarshalBenchScript(NumEntries);
+    FString Error;
+
+    // Warm up the chunk cache so both paths measure execution + marshaling only
+    FLuaFlatValue Warmup;
+    if (!Sandbox->RunStringFlat(Code, 10000, 1000, Warmup, Error))
+    {
+        UE_LOG(LogLuaRuntime, Error, TEXT("Lua.Bench.Marshal: script failed: %s"), *Error);
+        Sandbox->Close();
+        return;
+    }
+
+    double DynSeconds = 0.0;
+    int32 DynObjects = 0;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        const int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+        const double Start = FPlatformTime::Seconds();
+        FLuaDynValue Dyn;
+        Sandbox->RunStringDyn(Code, 10000, 1000, Dyn, Error);
+        DynSeconds += FPlatformTime::Seconds() - Start;
+        DynObjects = GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore;
+    }
+
+    double FlatSeconds = 0.0;
+    int32 FlatNodes = 0;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        const double Start = FPlatformTime::Seconds();
+        FLuaFlatValue Flat;
+        Sandbox->RunStringFlat(Code, 10000, 1000, Flat, Error);
+        FlatSeconds += FPlatformTime::Seconds() - Start;
+        FlatNodes = Flat.Nodes.Num();
+    }
+
+    // Converting on demand is what a caller pays if it still needs the UObject form
+    const double ConvertStart = FPlatformTime::Seconds();
+    const FLuaDynValue Converted = Warmup.ToDynValue();
+    const double ConvertSeconds = FPlatformTime::Seconds() - ConvertStart;
+
+    UE_LOG(LogLuaRuntime, Display, TEXT("Lua.Bench.Marshal: %d entries, %d iterations"), NumEntries, Iterations);
+    UE_LOG(LogLuaRuntime, Display, TEXT("  Dyn : %.3f ms/iter, %d UObjects allocated per result"), DynSeconds * 1000.0 / Iterations, DynObjects);
+    UE_LOG(LogLuaRuntime, Display, TEXT("  Flat: %.3f ms/iter, %d nodes, 0 UObjects"), FlatSeconds * 1000.0 / Iterations, FlatNodes);
+    UE_LOG(LogLuaRuntime, Display, TEXT("  Flat -> Dyn on demand: %.3f ms (%d top-level items)"), ConvertSeconds * 1000.0, Converted.Array.Num());
+
+    Sandbox->Close();
+}
+
+// Field reads on a config-style table and method calls on class instances; each loop pass does 6 accesses.
+static FString MakeFieldAccessBenchScript(int32 Loops)
+{
+    return FString::Printf(TEXT(
+        "local cfg = {}\n"
+        "for i = 1, 60 do cfg['field' .. i] = i end\n"
+        "cfg.speed, cfg.gravity, cfg.friction, cfg.jump = 1, 2, 3, 4\n"
+        "local P = {}; P.__index = P\n"
+        "function P:step(dt) self.x = self.x + self.vx * dt end\n"
+        "function P:len() return self.x end\n"
+        "local p = setmetatable({ x = 0, vx = 1 }, P)\n"
+        "local s = 0\n"
+        "for i = 1, %d do\n"
+        "  s = s + cfg.speed + cfg.gravity + cfg.friction + cfg.field42\n"
+        "  p:step(0.016); s = s + p:len()\n"
+        "end\n"
+        "return s\n"), Loops);
+}
+
+static void RunFieldAccessBenchmark(const TArray<FString>& Args)
+{
+    const int32 Loops = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000000;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+
+    ULuaSandbox* Sandbox = NewObject<ULuaSandbox>(GetTransientPackage());
+    Sandbox->Initialize(64 * 1024);
+
+    const FString Code = MakeFieldAccessBenchScript(Loops);
+    FString Error;
+    FLuaFlatValue Result;
+    if (!Sandbox->RunStringFlat(Code, 60000, 100000, Result, Error))
+    {
+        UE_LOG(LogLuaRuntime, Error, TEXT("Lua.Bench.FieldAccess: script failed: %s"), *Error);
+        Sandbox->Close();
+        return;
+    }
+
+    // Best of N: the loop is short enough that scheduling noise dominates the mean
+    double BestSeconds = DBL_MAX;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        const double Start = FPlatformTime::Seconds();
+        Sandbox->RunStringFlat(Code, 60000, 100000, Result, Error);
+        BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - Start);
+    }
+
+    UE_LOG(LogLuaRuntime, Display, TEXT("Lua.Bench.FieldAccess: %d loops, best of %d, inline caches %s"),
+        Loops, Iterations, LUAI_INLINECACHE ? TEXT("on") : TEXT("off (LUAI_INLINECACHE=0)"));
+    UE_LOG(LogLuaRuntime, Display, TEXT("  %.3f ms, %.2f ns per field access"),
+        BestSeconds * 1000.0, BestSeconds * 1.0e9 / (Loops * 6.0));
+
+    Sandbox->Close();
+}
+
+// The same integration step written with x/y/z tables and with the built-in vector type; one op per loop pass.
+static FString MakeVectorBenchScript(int32 Loops, bool bNative)
+{
+    if (bNative)
+    {
+        return FString::Printf(TEXT(
+            "local p, v = vector.new(0, 0, 0), vector.new(1, 2, 3)\n"
+            "for i = 1, %d do p = p + v * 0.016 end\n"
+            "return p.x\n"), Loops);
+    }
+    return FString::Printf(TEXT(
+        "local function vec(x, y, z) return { x = x, y = y, z = z } end\n"
+        "local p, v = vec(0, 0, 0), vec(1, 2, 3)\n"
+        "for i = 1, %d do p = vec(p.x + v.x * 0.016, p.y + v.y * 0.016, p.z + v.z * 0.016) end\n"
+        "return p.x\n"), Loops);
+}
+
+static void RunVectorBenchmark(const TArray<FString>& Args)
+{
+    const int32 Loops = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000000;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+
+    ULuaSandbox* Sandbox = NewObject<ULuaSandbox>(GetTransientPackage());
+    Sandbox->Initialize(64 * 1024);
+
+    UE_LOG(LogLuaRuntime, Display, TEXT("Lua.Bench.Vector: %d loops, best of %d"), Loops, Iterations);
+    for (const bool bNative : { false, true })
+    {
+        const FString Code = MakeVectorBenchScript(Loops, bNative);
+        double BestSeconds = DBL_MAX;
+        for (int32 i = 0; i < Iterations; ++i)
+        {
+            FLuaFlatValue Result;
+            FString Error;
+            const double Start = FPlatformTime::Seconds();
+            if (!Sandbox->RunStringFlat(Code, 60000, 100000, Result, Error))
+            {
+                UE_LOG(LogLuaRuntime, Error, TEXT("Lua.Bench.Vector: script failed: %s"), *Error);
+                break;
+            }
+            BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - Start);
+        }
+        if (BestSeconds != DBL_MAX)
+        {
+            UE_LOG(LogLuaRuntime, Display, TEXT("  %-6s %.3f ms, %.2f ns per step"), bNative ? TEXT("vector") : TEXT("table"),
+                BestSeconds * 1000.0, BestSeconds * 1.0e9 / Loops);
+        }
+    }
+
+    Sandbox->Close();
+}
+
+// Host array -> script pass -> host array, once through a Lua table (Flat marshaling) and once through a typed buffer
+static void RunBufferBenchmark(const TArray<FString>& Args)
+{
+    const int32 NumElements = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 5;
+
+    ULuaSandbox* Sandbox = NewObject<ULuaSandbox>(GetTransientPackage());
+    Sandbox->Initialize(64 * 1024);
+
+    TArray<float> Values;
+    Values.SetNumUninitialized(NumElements);
+    for (int32 i = 0; i < NumElements; ++i)
+    {
+        Values[i] = (float)i;
+    }
+
+    FLuaFlatValue Table;
+    Table.Nodes.AddDefaulted(NumElements + 1);
+    Table.Nodes[0].Type = ELuaType::Array;
+    Table.Nodes[0].FirstChild = 1;
+    Table.Nodes[0].NumChildren = NumElements;
+    for (int32 i = 0; i < NumElements; ++i)
+    {
+        Table.Nodes[i + 1].Type = ELuaType::Number;
+        Table.Nodes[i + 1].Number = Values[i];
+    }
+
+    const TCHAR* TableCode = TEXT(
+        "local s = 0\n"
+        "for i = 1, #data do local v = data[i] * 0.5 + 1; data[i] = v; s = s + v end\n"
+        "return s\n");
+    const TCHAR* BufferCode = TEXT("return data:scale(0.5):add(1):sum()\n");
+
+    double TableSeconds = DBL_MAX;
+    double BufferSeconds = DBL_MAX;
+    FString Error;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        FLuaFlatValue Result;
+        double Start = FPlatformTime::Seconds();
+        Sandbox->SetGlobalFlat(TEXT("data"), Table);
+        bool bOk = Sandbox->RunStringFlat(TableCode, 60000, 100000, Result, Error);
+        FLuaFlatValue TableOut;
+        Sandbox->GetGlobalFlat(TEXT("data"), TableOut);
+        TableSeconds = FMath::Min(TableSeconds, FPlatformTime::Seconds() - Start);
+
+        Start = FPlatformTime::Seconds();
+        bOk = bOk && Sandbox->SetGlobalFloatBuffer(TEXT("data"), Values);
+        bOk = bOk && Sandbox->RunStringFlat(BufferCode, 60000, 100000, Result, Error);
+        TArray<float> BufferOut;
+        bOk = bOk && Sandbox->GetGlobalFloatBuffer(TEXT("data"), BufferOut);
+        BufferSeconds = FMath::Min(BufferSeconds, FPlatformTime::Seconds() - Start);
+
+        if (!bOk)
+        {
+            UE_LOG(LogLuaRuntime, Error, TEXT("Lua.Bench.Buffer: failed: %s"), *Error);
+            Sandbox->Close();
+            return;
+        }
+        Sandbox->ClearGlobal(TEXT("data"));
+    }
+
+    UE_LOG(LogLuaRuntime, Display, TEXT("Lua.Bench.Buffer: %d elements, best of %d"), NumElements, Iterations);
+    UE_LOG(LogLuaRuntime, Display, TEXT("  table : %.3f ms"), TableSeconds * 1000.0);
+    UE_LOG(LogLuaRuntime, Display, TEXT("  buffer: %.3f ms"), BufferSeconds * 1000.0);
+
+    Sandbox->Close();
+}
+
+// Interpreter workloads, one per hot area of the VM: dispatch and arithmetic (lvm.c), hash and array
+// parts of tables (ltable.c), and allocation churn for the collector (lgc.c)
+struct FLuaVMBenchScript
+{
+    const TCHAR* Name;
+    const TCHAR* Code;
+};
+
+static const FLuaVMBenchScript GLuaVMBenchScripts[] =
+{
+    { TEXT("arith"), TEXT(
+        "local s, x = 0, 1.5\n"
+        "for i = 1, 2000000 do\n"
+        "  s = s + (i % 7) * x - (i // 3)\n"
+        "  if s > 1e9 then s = 0 end\n"
+        "end\n"
+        "return s\n") },
+    { TEXT("tables"), TEXT(
+        "local t, h = {}, {}\n"
+        "for i = 1, 200000 do t[i] = i; h['k' .. (i % 1000)] = i end\n"
+        "local s = 0\n"
+        "for r = 1, 5 do\n"
+        "  for i = 1, #t do s = s + t[i] end\n"
+        "  for k, v in pairs(h) do s = s + v end\n"
+        "end\n"
+        "return s\n") },
+    { TEXT("fields"), TEXT(
+        "local P = {}; P.__index = P\n"
+        "function P:step(dt) self.x = self.x + self.vx * dt; self.y = self.y + self.vy * dt end\n"
+        "local ps = {}\n"
+        "for i = 1, 1000 do ps[i] = setmetatable({ x = i, y = -i, vx = 1, vy = 2 }, P) end\n"
+        "for it = 1, 300 do\n"
+        "  for i = 1, #ps do ps[i]:step(0.016) end\n"
+        "end\n"
+        "return ps[1].x\n") },
+    { TEXT("gc"), TEXT(
+        "local keep = {}\n"
+        "for i = 1, 300000 do\n"
+        "  local v = { i, tostring(i), { x = i } }\n"
+        "  if i % 100 == 0 then keep[#keep + 1] = v end\n"
+        "end\n"
+        "return #keep\n") },
+};
+
+static void RunVMBenchmark(const TArray<FString>& Args)
+{
+    const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 3;
+
+    ULuaSandbox* Sandbox = NewObject<ULuaSandbox>(GetTransientPackage());
+    Sandbox->Initialize(256 * 1024);
+
+#if defined(LUA_USE_JUMPTABLE) && LUA_USE_JUMPTABLE
+    const TCHAR* Dispatch = TEXT("computed goto");
+#else
+    const TCHAR* Dispatch = TEXT("switch");
+#endif
+#if defined(ENABLE_PGO_PROFILE) && ENABLE_PGO_PROFILE
+    const TCHAR* Pgo = TEXT(", PGO profiling build (profile is written on exit)");
+#else
+    const TCHAR* Pgo = TEXT("");
+#endif
+    UE_LOG(LogLuaRuntime, Display, TEXT("Lua.Bench.VM: %d iterations, %s dispatch%s"), Iterations, Dispatch, Pgo);
+
+    double TotalSeconds = 0.0;
+    for (const FLuaVMBenchScript& Script : GLuaVMBenchScripts)
+    {
+        double BestSeconds = DBL_MAX;
+        for (int32 i = 0; i < Iterations; ++i)
+        {
+            FLuaFlatValue Result;
+            FString Error;
+            const double Start = FPlatformTime::Seconds();
+            if (!Sandbox->RunStringFlat(Script.Code, 60000, 100000, Result, Error))
+            {
+                UE_LOG(LogLuaRuntime, Error, TEXT("Lua.Bench.VM: %s failed: %s"), Script.Name, *Error);
+                break;
+            }
+            BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - Start);
+        }
+        if (BestSeconds != DBL_MAX)
+        {
+            TotalSeconds += BestSeconds;
+            UE_LOG(LogLuaRuntime, Display, TEXT("  %-7s %.3f ms"), Script.Name, BestSeconds * 1000.0);
+        }
+    }
+    UE_LOG(LogLuaRuntime, Display, TEXT("  total   %.3f ms"), TotalSeconds * 1000.0);
+
+    Sandbox->Close();
+}
+
+static FAutoConsoleCommand GLuaBenchMarshalCommand(
+    TEXT("Lua.Bench.Marshal"),
+    TEXT("Compare FLuaDynValue and FLuaFlatValue marshaling of a large returned table. Usage: Lua.Bench.Marshal [Entries=10000] [Iterations=5]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunMarshalBenchmark));
+
+static FAutoConsoleCommand GLuaBenchFieldAccessCommand(
+    TEXT("Lua.Bench.FieldAccess"),
+    TEXT("Time GETFIELD/SELF-heavy code; compare builds with and without LUAI_INLINECACHE. Usage: Lua.Bench.FieldAccess [Loops=1000000] [Iterations=5]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunFieldAccessBenchmark));
+
+static FAutoConsoleCommand GLuaBenchVectorCommand(
+    TEXT("Lua.Bench.Vector"),
+    TEXT("Compare x/y/z table vectors with the built-in vector type on a position update. Usage: Lua.Bench.Vector [Loops=1000000] [Iterations=5]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunVectorBenchmark));
+
+static FAutoConsoleCommand GLuaBenchBufferCommand(
+    TEXT("Lua.Bench.Buffer"),
+    TEXT("Round-trip a float array through a script as a Lua table and as a typed buffer. Usage: Lua.Bench.Buffer [Elements=100000] [Iterations=5]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunBufferBenchmark));
+
+static FAutoConsoleCommand GLuaBenchVMCommand(
+    TEXT("Lua.Bench.VM"),
+    TEXT("Time interpreter, table and GC workloads (best of N); also the training run for PGO builds. Usage: Lua.Bench.VM [Iterations=3]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunVMBenchmark));
+
+}
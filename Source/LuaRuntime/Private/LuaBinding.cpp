@@ -0,0 +1,232 @@
+#include "LuaBinding.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+}
+
+namespace {
+
+// Number field of the table at Index; accepts the named key or, for array-style tables, the position.
+// Raw reads that never allocate (the key is matched while traversing), so no Lua error can skip the destructors of
+// arguments already read.
+static bool GetNumberField(lua_State* L, int Index, const char* Key, lua_Integer Position, double& Out)
+{
+    bool bFound = false;
+    lua_pushnil(L);
+    while (lua_next(L, Index) != 0)
+    {
+        if (lua_type(L, -2) == LUA_TSTRING && FCStringAnsi::Strcmp(lua_tostring(L, -2), Key) == 0)
+        {
+            lua_remove(L, -2);
+            bFound = true;
+            break;
+        }
+        lua_pop(L, 1);
+    }
+    if (!bFound)
+    {
+        lua_rawgeti(L, Index, Position);
+    }
+    int bIsNum = 0;
+    Out = (double)lua_tonumberx(L, -1, &bIsNum);
+    lua_pop(L, 1);
+    return bIsNum != 0;
+}
+
+}
+
+namespace LuaBinding
+{
+
+bool ToBoolean(lua_State* L, int Index)
+{
+    return lua_toboolean(L, Index) != 0;
+}
+
+bool ToInteger(lua_State* L, int Index, int64& Out)
+{
+    int bIsNum = 0;
+    Out = (int64)lua_tointegerx(L, Index, &bIsNum);
+    return bIsNum != 0;
+}
+
+bool ToNumber(lua_State* L, int Index, double& Out)
+{
+    int bIsNum = 0;
+    Out = (double)lua_tonumberx(L, Index, &bIsNum);
+    return bIsNum != 0;
+}
+
+bool ToUtf8View(lua_State* L, int Index, FUtf8StringView& Out)
+{
+    // Strings only: lua_tolstring would convert a number in place, which allocates and can raise
+    if (lua_type(L, Index) != LUA_TSTRING)
+    {
+        return false;
+    }
+    size_t Len = 0;
+    const char* Str = lua_tolstring(L, Index, &Len);
+    Out = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Str), (int32)Len);
+    return true;
+}
+
+bool ToString(lua_State* L, int Index, FString& Out)
+{
+    FUtf8StringView View;
+    if (!ToUtf8View(L, Index, View))
+    {
+        return false;
+    }
+    FUTF8ToTCHAR Convert(reinterpret_cast<const ANSICHAR*>(View.GetData()), View.Len());
+    Out = FString(Convert.Length(), Convert.Get());
+    return true;
+}
+
+bool ToName(lua_State* L, int Index, FName& Out)
+{
+    FUtf8StringView View;
+    if (!ToUtf8View(L, Index, View))
+    {
+        return false;
+    }
+    FUTF8ToTCHAR Convert(reinterpret_cast<const ANSICHAR*>(View.GetData()), View.Len());
+    Out = FName(Convert.Length(), Convert.Get());
+    return true;
+}
+
+bool ToVector(lua_State* L, int Index, FVector& Out)
+{
+    lua_Number v[3];
+    if (lua_tovector(L, Index, v))
+    {
+        Out = FVector(v[0], v[1], v[2]);
+        return true;
+    }
+    if (!lua_istable(L, Index)) return false;
+    Index = lua_absindex(L, Index);
+    return GetNumberField(L, Index, "x", 1, Out.X) && GetNumberField(L, Index, "y", 2, Out.Y) && GetNumberField(L, Index, "z", 3, Out.Z);
+}
+
+bool ToVector2D(lua_State* L, int Index, FVector2D& Out)
+{
+    if (!lua_istable(L, Index)) return false;
+    Index = lua_absindex(L, Index);
+    return GetNumberField(L, Index, "x", 1, Out.X) && GetNumberField(L, Index, "y", 2, Out.Y);
+}
+
+bool ToRotator(lua_State* L, int Index, FRotator& Out)
+{
+    if (!lua_istable(L, Index)) return false;
+    Index = lua_absindex(L, Index);
+    return GetNumberField(L, Index, "pitch", 1, Out.Pitch) && GetNumberField(L, Index, "yaw", 2, Out.Yaw) && GetNumberField(L, Index, "roll", 3, Out.Roll);
+}
+
+void StageBoolean(FLuaBindingResult& Out, bool Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Boolean;
+    Out.bBoolean = Value;
+}
+
+void StageInteger(FLuaBindingResult& Out, int64 Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Integer;
+    Out.Integer = Value;
+}
+
+void StageNumber(FLuaBindingResult& Out, double Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Number;
+    Out.Numbers[0] = Value;
+}
+
+void StageString(FLuaBindingResult& Out, const FString& Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::String;
+    FTCHARToUTF8 Convert(*Value);
+    Out.Utf8.Reset();
+    Out.Utf8.Append(Convert.Get(), Convert.Length());
+}
+
+void StageName(FLuaBindingResult& Out, FName Value)
+{
+    StageString(Out, Value.ToString());
+}
+
+void StageVector(FLuaBindingResult& Out, const FVector& Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Vector;
+    Out.Numbers[0] = Value.X;
+    Out.Numbers[1] = Value.Y;
+    Out.Numbers[2] = Value.Z;
+}
+
+void StageVector2D(FLuaBindingResult& Out, const FVector2D& Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Table;
+    Out.NumFields = 2;
+    Out.FieldNames[0] = "x";
+    Out.FieldNames[1] = "y";
+    Out.Numbers[0] = Value.X;
+    Out.Numbers[1] = Value.Y;
+}
+
+void StageRotator(FLuaBindingResult& Out, const FRotator& Value)
+{
+    Out.Kind = FLuaBindingResult::EKind::Table;
+    Out.NumFields = 3;
+    Out.FieldNames[0] = "pitch";
+    Out.FieldNames[1] = "yaw";
+    Out.FieldNames[2] = "roll";
+    Out.Numbers[0] = Value.Pitch;
+    Out.Numbers[1] = Value.Yaw;
+    Out.Numbers[2] = Value.Roll;
+}
+
+void PushResult(lua_State* L, const FLuaBindingResult& Result)
+{
+    switch (Result.Kind)
+    {
+    case FLuaBindingResult::EKind::Boolean:
+        lua_pushboolean(L, Result.bBoolean ? 1 : 0);
+        break;
+    case FLuaBindingResult::EKind::Integer:
+        lua_pushinteger(L, (lua_Integer)Result.Integer);
+        break;
+    case FLuaBindingResult::EKind::Number:
+        lua_pushnumber(L, (lua_Number)Result.Numbers[0]);
+        break;
+    case FLuaBindingResult::EKind::String:
+        lua_pushlstring(L, Result.Utf8.GetData(), Result.Utf8.Num());
+        break;
+    case FLuaBindingResult::EKind::Vector:
+        lua_pushvector(L, Result.Numbers[0], Result.Numbers[1], Result.Numbers[2]);
+        break;
+    case FLuaBindingResult::EKind::Table:
+        lua_createtable(L, 0, Result.NumFields);
+        for (int32 i = 0; i < Result.NumFields; ++i)
+        {
+            lua_pushnumber(L, (lua_Number)Result.Numbers[i]);
+            lua_setfield(L, -2, Result.FieldNames[i]);
+        }
+        break;
+    }
+}
+
+FLuaNativeBinding* GetRunningBinding(lua_State* L)
+{
+    return static_cast<FLuaNativeBinding*>(lua_touserdata(L, lua_upvalueindex(1)));
+}
+
+int RaiseArgError(lua_State* L, int Arg, const char* Expected)
+{
+    return luaL_typeerror(L, Arg, Expected);
+}
+
+int RaiseUnboundError(lua_State* L)
+{
+    return luaL_error(L, "native function is not bound in this sandbox");
+}
+
+}
@@ -56,7 +56,14 @@ FLuaRunResult ULuaBlueprintLibrary::ExecuteLuaScriptAsset(const UObject* WorldCo
     }
     if (ULuaRuntimeSubsystem* Subsys = GetLuaRuntimeSubsystem(WorldContextObject))
     {
-        return Subsys->ExecuteString(Script->GetSource(), MemoryLimitKB, TimeoutMs, HookInterval);
+        ULuaSandbox* Box = Subsys->AcquireSandbox(MemoryLimitKB);
+        if (!Box)
+        {
+            FLuaRunResult R; R.bSuccess = false; R.Error = TEXT("Failed to create sandbox"); return R;
+        }
+        const FLuaRunResult R = Box->RunScript(Script, TimeoutMs, HookInterval);
+        Subsys->ReleaseSandbox(Box);
+        return R;
     }
     FLuaRunResult R; R.bSuccess = false; R.Error = TEXT("LuaRuntimeSubsystem not available"); return R;
 }
@@ -66,10 +73,10 @@ bool ULuaBlueprintLibrary::ExecuteLuaChunkDyn(const UObject* WorldContextObject,
     OutError.Empty();
     if (ULuaRuntimeSubsystem* Subsys = GetLuaRuntimeSubsystem(WorldContextObject))
     {
-        ULuaSandbox* Box = Subsys->CreateSandbox(MemoryLimitKB);
+        ULuaSandbox* Box = Subsys->AcquireSandbox(MemoryLimitKB);
         if (!Box) { OutError = TEXT("Failed to create sandbox"); return false; }
         const bool bOk = Box->RunStringDyn(Code, TimeoutMs, HookInterval, OutValue, OutError);
-        Box->Close();
+        Subsys->ReleaseSandbox(Box);
         return bOk;
     }
     OutError = TEXT("LuaRuntimeSubsystem not available");
@@ -81,10 +88,10 @@ bool ULuaBlueprintLibrary::EvaluateLuaExpressionDyn(const UObject* WorldContextO
     OutError.Empty();
     if (ULuaRuntimeSubsystem* Subsys = GetLuaRuntimeSubsystem(WorldContextObject))
     {
-        ULuaSandbox* Box = Subsys->CreateSandbox(MemoryLimitKB);
+        ULuaSandbox* Box = Subsys->AcquireSandbox(MemoryLimitKB);
         if (!Box) { OutError = TEXT("Failed to create sandbox"); return false; }
         const bool bOk = Box->EvaluateExpressionDyn(Expression, TimeoutMs, OutValue, OutError);
-        Box->Close();
+        Subsys->ReleaseSandbox(Box);
         return bOk;
     }
     OutError = TEXT("LuaRuntimeSubsystem not available");
@@ -0,0 +1,137 @@
+#include "LuaChunkCache.h"
+#include "LuaRuntimeSettings.h"
+#include "Hash/CityHash.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+}
+
+FLuaChunkCache& FLuaChunkCache::Get()
+{
+    static FLuaChunkCache Instance;
+    return Instance;
+}
+
+int FLuaChunkCache::WriteBytecode(lua_State* /*L*/, const void* Data, size_t Size, void* UserData)
+{
+    TArray<uint8>* Out = static_cast<TArray<uint8>*>(UserData);
+    Out->Append(static_cast<const uint8*>(Data), (int32)Size);
+    return 0;
+}
+
+int FLuaChunkCache::Load(lua_State* L, const char* Source, int32 Len, const char* ChunkName)
+{
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    if (!Settings || !Settings->bEnableChunkCache)
+    {
+        return luaL_loadbufferx(L, Source, Len, ChunkName, "t");
+    }
+
+    FKey Key;
+    Key.Hash = CityHash64WithSeed(Source, (uint32)Len, CityHash64(ChunkName, (uint32)FCStringAnsi::Strlen(ChunkName)));
+    Key.Crc = FCrc::MemCrc32(Source, Len);
+    Key.Len = Len;
+
+    TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Cached;
+    {
+        FScopeLock ScopeLock(&Lock);
+        if (FEntry* Entry = Entries.Find(Key))
+        {
+            Entry->LastUse = ++UseCounter;
+            Cached = Entry->Bytecode;
+            ++Hits;
+        }
+        else
+        {
+            ++Misses;
+        }
+    }
+
+    if (Cached.IsValid())
+    {
+        // Trusted path: the bytecode was dumped by Load below from text we compiled ourselves
+        const int Status = luaL_loadbufferx(L, reinterpret_cast<const char*>(Cached->GetData()), Cached->Num(), ChunkName, "b");
+        if (Status == LUA_OK)
+        {
+            return Status;
+        }
+        lua_pop(L, 1);
+    }
+
+    const int Status = luaL_loadbufferx(L, Source, Len, ChunkName, "t");
+    if (Status != LUA_OK)
+    {
+        return Status;
+    }
+
+    TArray<uint8> Bytecode;
+    lua_dump(L, &WriteBytecode, &Bytecode, 0);
+    Insert(Key, MoveTemp(Bytecode), (int64)Settings->ChunkCacheMaxKB * 1024);
+    return Status;
+}
+
+void FLuaChunkCache::Insert(const FKey& Key, TArray<uint8>&& Bytecode, int64 MaxBytes)
+{
+    const int64 Size = Bytecode.Num();
+    if (Size == 0 || Size > MaxBytes)
+    {
+        return;
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    if (FEntry* Existing = Entries.Find(Key))
+    {
+        BytecodeBytes -= Existing->Bytecode->Num();
+        Entries.Remove(Key);
+    }
+
+    // Evict least recently used entries until the new one fits
+    while (BytecodeBytes + Size > MaxBytes && Entries.Num() > 0)
+    {
+        const FKey* OldestKey = nullptr;
+        uint64 OldestUse = MAX_uint64;
+        for (const auto& Pair : Entries)
+        {
+            if (Pair.Value.LastUse < OldestUse)
+            {
+                OldestUse = Pair.Value.LastUse;
+                OldestKey = &Pair.Key;
+            }
+        }
+        const FKey Evicted = *OldestKey;
+        BytecodeBytes -= Entries[Evicted].Bytecode->Num();
+        Entries.Remove(Evicted);
+        ++Evictions;
+    }
+
+    FEntry Entry;
+    Entry.Bytecode = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(Bytecode));
+    Entry.LastUse = ++UseCounter;
+    Entries.Add(Key, MoveTemp(Entry));
+    BytecodeBytes += Size;
+}
+
+FLuaChunkCacheStats FLuaChunkCache::GetStats() const
+{
+    FScopeLock ScopeLock(&Lock);
+    FLuaChunkCacheStats Stats;
+    Stats.Hits = Hits;
+    Stats.Misses = Misses;
+    Stats.Evictions = Evictions;
+    Stats.NumEntries = Entries.Num();
+    Stats.BytecodeBytes = BytecodeBytes;
+    const int64 Total = Hits + Misses;
+    Stats.HitRate = Total > 0 ? (float)((double)Hits / (double)Total) : 0.0f;
+    return Stats;
+}
+
+void FLuaChunkCache::Empty()
+{
+    FScopeLock ScopeLock(&Lock);
+    Entries.Empty();
+    BytecodeBytes = 0;
+}
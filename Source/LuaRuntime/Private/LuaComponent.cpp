@@ -17,14 +17,45 @@ void ULuaComponent::BeginPlay()
     {
         ExecuteConfiguredScript();
     }
+    if (bEnableLuaTick)
+    {
+        SetLuaTickEnabled(true);
+    }
 }
 
 void ULuaComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+    // Leave bEnableLuaTick alone: it is the designer's setting and must survive a re-registered BeginPlay
+    if (ULuaRuntimeSubsystem* Subsys = GetRuntimeSubsystem())
+    {
+        Subsys->UnregisterLuaTick(this);
+    }
     ResetSandbox();
     Super::EndPlay(EndPlayReason);
 }
 
+ULuaRuntimeSubsystem* ULuaComponent::GetRuntimeSubsystem() const
+{
+    UGameInstance* GI = GetWorld() ? GetWorld()->GetGameInstance() : nullptr;
+    return GI ? GI->GetSubsystem<ULuaRuntimeSubsystem>() : nullptr;
+}
+
+void ULuaComponent::SetLuaTickEnabled(bool bEnabled)
+{
+    bEnableLuaTick = bEnabled;
+    if (ULuaRuntimeSubsystem* Subsys = GetRuntimeSubsystem())
+    {
+        if (bEnabled)
+        {
+            Subsys->RegisterLuaTick(this);
+        }
+        else
+        {
+            Subsys->UnregisterLuaTick(this);
+        }
+    }
+}
+
 ULuaSandbox* ULuaComponent::EnsureSandbox()
 {
     if (!GetWorld())
@@ -82,7 +113,7 @@ FLuaRunResult ULuaComponent::ExecuteConfiguredScript()
     }
     else if (bUseAsset && ScriptAsset)
     {
-        return Box->RunString(ScriptAsset->GetSource(), TimeoutMs, HookInterval);
+        return Box->RunScript(ScriptAsset, TimeoutMs, HookInterval);
     }
     else
     {
@@ -1,6 +1,8 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "LuaRuntime.h"
+#include "LuaChunkCache.h"
+#include "LuaWatchdog.h"
 
 #define LOCTEXT_NAMESPACE "FLuaRuntimeModule"
 
@@ -15,6 +17,8 @@ void FLuaRuntimeModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FLuaChunkCache::Get().Empty();
+	FLuaWatchdog::Get().Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
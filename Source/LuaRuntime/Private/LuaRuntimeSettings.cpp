@@ -11,6 +11,31 @@ ULuaRuntimeSettings::ULuaRuntimeSettings()
     // Execution defaults
     DefaultMemoryLimitKB = 1024;
     DefaultTimeoutMs = 50;
+    DefaultInstructionBudget = 0;
+    DefaultFrameInstructionBudget = 0;
     DefaultHookInterval = 1000;
+    bUseWatchdogTimeouts = true;
+
+    // Memory defaults
+    bUseSmallObjectPool = true;
+    bUseArenaForOneShotSandboxes = false;
+    bShareInternedStrings = true;
+    GCStepBudgetMicroseconds = 0;
+    GCStepSizeKB = 0;
+    GCStepAheadKB = 64;
+
+    // Sandbox pool defaults
+    bEnableSandboxPool = true;
+    SandboxPoolMaxPerClass = 8;
+    SandboxPoolPrewarmClassesKB = { 1024 };
+    SandboxPoolPrewarmCount = 2;
+
+    // Chunk cache defaults
+    bEnableChunkCache = true;
+    ChunkCacheMaxKB = 8192;
+
+    // Cooking defaults
+    bCookScriptBytecode = true;
+    bStripCookedDebugInfo = false;
 }
 
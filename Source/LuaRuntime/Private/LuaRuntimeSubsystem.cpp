@@ -1,6 +1,14 @@
 #include "LuaRuntimeSubsystem.h"
 #include "LuaSandbox.h"
+#include "LuaRuntime.h"
+#include "LuaRuntimeSettings.h"
+#include "LuaSandboxImage.h"
+#include "LuaComponent.h"
+#include "LuaTickBatch.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
 #include "Misc/FileHelper.h"
+#include <atomic>
 
 // Lua headers for syntax validation
 extern "C" {
@@ -8,22 +16,199 @@ extern "C" {
 #include "lauxlib.h"
 }
 
+void ULuaRuntimeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    GCStepBudgetUs = Settings ? Settings->GCStepBudgetMicroseconds : 0;
+    if (Settings && Settings->bEnableSandboxPool)
+    {
+        const int32 PrewarmCount = FMath::Min(Settings->SandboxPoolPrewarmCount, Settings->SandboxPoolMaxPerClass);
+        for (const int32 ClassKB : Settings->SandboxPoolPrewarmClassesKB)
+        {
+            FLuaSandboxPoolBucket& Bucket = SandboxPool.FindOrAdd(ClassKB);
+            for (int32 i = 0; i < PrewarmCount; ++i)
+            {
+                if (ULuaSandbox* Box = CreatePooledSandbox(ClassKB))
+                {
+                    Bucket.Idle.Add(Box);
+                }
+            }
+        }
+    }
+}
+
+void ULuaRuntimeSubsystem::Deinitialize()
+{
+    for (const TSharedPtr<FLuaTickBatch>& Batch : TickBatches)
+    {
+        Batch->UnRegisterTickFunction();
+        Batch->ReleaseRefs();
+    }
+    TickBatches.Empty();
+
+    TrimSandboxPool();
+    ClearAllSandboxes();
+    GCSandboxes.Empty();
+    Super::Deinitialize();
+}
+
+void ULuaRuntimeSubsystem::Tick(float DeltaTime)
+{
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    const int32 StepKB = Settings ? Settings->GCStepSizeKB : 0;
+    const int64 AheadBytes = (int64)(Settings ? Settings->GCStepAheadKB : 64) * 1024;
+
+    GCSandboxes.RemoveAllSwap([](const TWeakObjectPtr<ULuaSandbox>& Box) { return !Box.IsValid(); });
+    const int32 Num = GCSandboxes.Num();
+    if (Num == 0)
+    {
+        return;
+    }
+
+    // Keep stepping until the budget runs out or every sandbox is done for this frame: a sandbox is done when its
+    // collector finishes a cycle, or when it is idle with more than AheadBytes of headroom (debt is as of the last
+    // call or step, and nothing allocates in between)
+    const double Deadline = FPlatformTime::Seconds() + GCStepBudgetUs * 1e-6;
+    TBitArray<> Done(false, Num);
+    int32 NumDone = 0;
+    while (NumDone < Num && FPlatformTime::Seconds() < Deadline)
+    {
+        GCCursor = (GCCursor + 1) % Num;
+        if (Done[GCCursor])
+        {
+            continue;
+        }
+
+        ULuaSandbox* Box = GCSandboxes[GCCursor].Get();
+        // A sandbox with async work queued belongs to its worker thread
+        const bool bSkip = !Box->IsInitialized() || Box->IsBusy() || Box->GetMemoryStats().GCDebtBytes < -AheadBytes;
+        if (bSkip || Box->StepGC(StepKB))
+        {
+            Done[GCCursor] = true;
+            ++NumDone;
+        }
+    }
+}
+
+ETickableTickType ULuaRuntimeSubsystem::GetTickableTickType() const
+{
+    return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+bool ULuaRuntimeSubsystem::IsTickable() const
+{
+    return GCStepBudgetUs > 0;
+}
+
+TStatId ULuaRuntimeSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(ULuaRuntimeSubsystem, STATGROUP_Tickables);
+}
+
+void ULuaRuntimeSubsystem::SetGCStepBudget(int32 Microseconds)
+{
+    GCStepBudgetUs = FMath::Max(Microseconds, 0);
+}
+
+void ULuaRuntimeSubsystem::AddGCSteppedSandbox(ULuaSandbox* Sandbox)
+{
+    if (Sandbox)
+    {
+        GCSandboxes.AddUnique(Sandbox);
+    }
+}
+
+void ULuaRuntimeSubsystem::RegisterLuaTick(ULuaComponent* Component)
+{
+    UnregisterLuaTick(Component);
+
+    UWorld* World = Component ? Component->GetWorld() : nullptr;
+    ULuaSandbox* Box = Component ? Component->EnsureSandbox() : nullptr;
+    if (!World || !World->PersistentLevel || !Box)
+    {
+        return;
+    }
+
+    // Empty batches are only disabled when their last member leaves (that can happen during their own tick), so
+    // they are destroyed here instead
+    for (int32 i = TickBatches.Num() - 1; i >= 0; --i)
+    {
+        FLuaTickBatch& Batch = *TickBatches[i];
+        if (!Batch.bExecuting && (Batch.Members.Num() == 0 || !Batch.World.IsValid() || !Batch.Sandbox.IsValid()))
+        {
+            Batch.UnRegisterTickFunction();
+            Batch.ReleaseRefs();
+            TickBatches.RemoveAtSwap(i);
+        }
+    }
+
+    const ETickingGroup Group = Component->LuaTickGroup;
+    const TSharedPtr<FLuaTickBatch>* Found = TickBatches.FindByPredicate([&](const TSharedPtr<FLuaTickBatch>& Batch)
+    {
+        return Batch->Sandbox == Box && Batch->World == World && Batch->TickGroup == Group && Batch->FunctionName == Component->LuaTickFunction;
+    });
+
+    TSharedPtr<FLuaTickBatch> Batch = Found ? *Found : nullptr;
+    if (!Batch)
+    {
+        Batch = MakeShared<FLuaTickBatch>();
+        Batch->Sandbox = Box;
+        Batch->World = World;
+        Batch->FunctionName = Component->LuaTickFunction;
+        Batch->TickGroup = Group;
+        Batch->EndTickGroup = Group;
+        Batch->bCanEverTick = true;
+        Batch->bStartWithTickEnabled = true;
+        Batch->RegisterTickFunction(World->PersistentLevel);
+        TickBatches.Add(Batch);
+    }
+    else if (!Batch->IsTickFunctionEnabled())
+    {
+        Batch->SetTickFunctionEnable(true);
+    }
+
+    Component->LuaTickId = ++LastLuaTickId;
+    Component->LuaTickBatch = Batch;
+    Batch->AddMember(Component, Component->LuaTickId);
+}
+
+void ULuaRuntimeSubsystem::UnregisterLuaTick(ULuaComponent* Component)
+{
+    const TSharedPtr<FLuaTickBatch> Batch = Component ? Component->LuaTickBatch.Pin() : nullptr;
+    if (!Batch)
+    {
+        return;
+    }
+
+    Batch->RemoveMember(Component->LuaTickId);
+    Component->LuaTickBatch.Reset();
+    Component->LuaTickId = 0;
+
+    if (Batch->Members.Num() == 0)
+    {
+        Batch->SetTickFunctionEnable(false);
+    }
+}
+
 ULuaSandbox* ULuaRuntimeSubsystem::CreateSandbox(int32 MemoryLimitKB)
 {
     ULuaSandbox* Box = NewObject<ULuaSandbox>(this);
     Box->Initialize(MemoryLimitKB);
+    GCSandboxes.Add(Box);
     return Box;
 }
 
 FLuaRunResult ULuaRuntimeSubsystem::ExecuteString(const FString& Code, int32 MemoryLimitKB, int32 TimeoutMs, int32 HookInterval)
 {
-    ULuaSandbox* Box = CreateSandbox(MemoryLimitKB);
+    ULuaSandbox* Box = AcquireSandbox(MemoryLimitKB);
     if (!Box)
     {
         FLuaRunResult R; R.bSuccess = false; R.Error = TEXT("Failed to create sandbox"); return R;
     }
     const FLuaRunResult R = Box->RunString(Code, TimeoutMs, HookInterval);
-    Box->Close();
+    ReleaseSandbox(Box);
     return R;
 }
 
@@ -41,6 +226,7 @@ ULuaSandbox* ULuaRuntimeSubsystem::CreateNamedSandbox(const FName SandboxName, i
     ULuaSandbox* Box = NewObject<ULuaSandbox>(this);
     Box->Initialize(MemoryLimitKB);
     NamedSandboxes.Add(SandboxName, Box);
+    GCSandboxes.Add(Box);
     return Box;
 }
 
@@ -96,6 +282,73 @@ FLuaRunResult ULuaRuntimeSubsystem::EvaluateExpression(const FString& Expression
     return ExecuteString(EvalCode, MemoryLimitKB, TimeoutMs, 1000);
 }
 
+TArray<FLuaRunResult> ULuaRuntimeSubsystem::EvaluateExpressionBatch(const FString& Expression, const TArray<FString>& ParamNames, const TArray<FLuaArgumentSet>& ArgumentSets, int32 NumWorkers, int32 MemoryLimitKB, int32 TimeoutMs)
+{
+    // Small batches are not worth another sandbox
+    static constexpr int32 MinItemsPerSandbox = 32;
+
+    TArray<FLuaRunResult> Results;
+    Results.SetNum(ArgumentSets.Num());
+    if (ArgumentSets.Num() == 0)
+    {
+        return Results;
+    }
+
+    if (NumWorkers <= 0)
+    {
+        NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+    }
+    NumWorkers = FMath::Clamp(NumWorkers, 1, FMath::DivideAndRoundUp(ArgumentSets.Num(), MinItemsPerSandbox));
+
+    // Sandboxes and compiled functions are set up on the game thread; the chunk cache makes every compile after the first a bytecode load
+    const FString FunctionCode = FString::Printf(TEXT("return function(%s) return %s end"), *FString::Join(ParamNames, TEXT(", ")), *Expression);
+    TArray<ULuaSandbox*> Boxes;
+    TArray<FLuaFunctionRef> Functions;
+    FString CompileError;
+    for (int32 i = 0; i < NumWorkers; ++i)
+    {
+        ULuaSandbox* Box = AcquireSandbox(MemoryLimitKB);
+        if (!Box)
+        {
+            CompileError = TEXT("Failed to create sandbox");
+            break;
+        }
+        FLuaFunctionRef Function;
+        if (!Box->LoadFunction(FunctionCode, Function, CompileError, TimeoutMs))
+        {
+            ReleaseSandbox(Box);
+            break;
+        }
+        Boxes.Add(Box);
+        Functions.Add(Function);
+    }
+
+    if (Boxes.Num() == 0)
+    {
+        for (FLuaRunResult& Result : Results)
+        {
+            Result.Error = CompileError;
+        }
+        return Results;
+    }
+
+    // Each worker owns one sandbox and pulls the next unclaimed item, so slow items do not stall a fixed partition
+    std::atomic<int32> NextItem{0};
+    ParallelFor(Boxes.Num(), [&](int32 Worker)
+    {
+        for (int32 Item = NextItem.fetch_add(1); Item < ArgumentSets.Num(); Item = NextItem.fetch_add(1))
+        {
+            Results[Item] = Boxes[Worker]->CallFunctionRef(Functions[Worker], ArgumentSets[Item].Args, TimeoutMs);
+        }
+    });
+
+    for (ULuaSandbox* Box : Boxes)
+    {
+        ReleaseSandbox(Box);
+    }
+    return Results;
+}
+
 void ULuaRuntimeSubsystem::ClearAllSandboxes()
 {
     for (auto& Pair : NamedSandboxes)
@@ -108,6 +361,177 @@ void ULuaRuntimeSubsystem::ClearAllSandboxes()
     NamedSandboxes.Empty();
 }
 
+ULuaSandbox* ULuaRuntimeSubsystem::CreateOneShotSandbox(int32 MemoryLimitKB)
+{
+    // One-shot sandboxes are fully collected on release, so they stay out of frame GC stepping
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    ULuaSandbox* Box = NewObject<ULuaSandbox>(this);
+    if (!Settings || !Settings->bUseArenaForOneShotSandboxes)
+    {
+        Box->Initialize(MemoryLimitKB);
+    }
+    else
+    {
+        Box->InitializeArena(MemoryLimitKB);
+    }
+    return Box;
+}
+
+ULuaSandbox* ULuaRuntimeSubsystem::CreatePooledSandbox(int32 MemoryLimitKB)
+{
+    ULuaSandbox* Box = CreateOneShotSandbox(MemoryLimitKB);
+    if (!Box->IsInitialized() || !Box->SaveBaseline())
+    {
+        Box->Close();
+        return nullptr;
+    }
+    return Box;
+}
+
+ULuaSandbox* ULuaRuntimeSubsystem::AcquireSandbox(int32 MemoryLimitKB)
+{
+    if (FLuaSandboxPoolBucket* Bucket = SandboxPool.Find(MemoryLimitKB))
+    {
+        while (Bucket->Idle.Num() > 0)
+        {
+            ULuaSandbox* Box = Bucket->Idle.Pop(EAllowShrinking::No);
+            if (Box && Box->IsInitialized())
+            {
+                ++PoolStats.Hits;
+                return Box;
+            }
+        }
+    }
+
+    ++PoolStats.Misses;
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    if (!Settings || !Settings->bEnableSandboxPool)
+    {
+        return CreateOneShotSandbox(MemoryLimitKB);
+    }
+    return CreatePooledSandbox(MemoryLimitKB);
+}
+
+void ULuaRuntimeSubsystem::ReleaseSandbox(ULuaSandbox* Sandbox)
+{
+    if (!Sandbox)
+    {
+        return;
+    }
+
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    const bool bPoolEnabled = Settings && Settings->bEnableSandboxPool;
+    const int32 MaxPerClass = Settings ? Settings->SandboxPoolMaxPerClass : 0;
+
+    // Callbacks bound by the previous user must not fire for the next one
+    Sandbox->OnLuaCallback.Clear();
+    Sandbox->ClearCallbacks();
+
+    FLuaSandboxPoolBucket& Bucket = SandboxPool.FindOrAdd(Sandbox->GetMemoryLimitKB());
+    if (bPoolEnabled && Bucket.Idle.Num() < MaxPerClass && !Bucket.Idle.Contains(Sandbox) && Sandbox->RestoreBaseline())
+    {
+        ++PoolStats.Resets;
+        Bucket.Idle.Add(Sandbox);
+        return;
+    }
+
+    ++PoolStats.Discards;
+    Sandbox->Close();
+}
+
+FLuaSandboxPoolStats ULuaRuntimeSubsystem::GetSandboxPoolStats() const
+{
+    FLuaSandboxPoolStats Stats = PoolStats;
+    Stats.IdleSandboxes = 0;
+    for (const auto& Pair : SandboxPool)
+    {
+        Stats.IdleSandboxes += Pair.Value.Idle.Num();
+    }
+    return Stats;
+}
+
+void ULuaRuntimeSubsystem::TrimSandboxPool()
+{
+    for (auto& Pair : SandboxPool)
+    {
+        for (ULuaSandbox* Box : Pair.Value.Idle)
+        {
+            if (Box)
+            {
+                Box->Close();
+            }
+        }
+    }
+    SandboxPool.Empty();
+}
+
+bool ULuaRuntimeSubsystem::CaptureGoldenImage(const FName ImageName, ULuaSandbox* Source, FString& OutError)
+{
+    if (!Source || !Source->IsInitialized())
+    {
+        OutError = TEXT("Source sandbox is not initialized");
+        return false;
+    }
+
+    TSharedPtr<const FLuaSandboxImage> Image = Source->CaptureImage(OutError);
+    if (!Image.IsValid())
+    {
+        return false;
+    }
+
+    UE_LOG(LogLuaRuntime, Log, TEXT("Captured Lua golden image '%s': %d nodes, %llu bytes"),
+        *ImageName.ToString(), Image->GetNumNodes(), (uint64)Image->GetAllocatedSize());
+    GoldenImages.Add(ImageName, MoveTemp(Image));
+    OutError.Empty();
+    return true;
+}
+
+ULuaSandbox* ULuaRuntimeSubsystem::CreateSandboxFromImage(const FName ImageName, int32 MemoryLimitKB)
+{
+    TSharedPtr<const FLuaSandboxImage> Image = GetGoldenImage(ImageName);
+    if (!Image.IsValid())
+    {
+        UE_LOG(LogLuaRuntime, Warning, TEXT("No Lua golden image named '%s'"), *ImageName.ToString());
+        return nullptr;
+    }
+
+    ULuaSandbox* Box = NewObject<ULuaSandbox>(this);
+    FString Error;
+    if (!Box->InitializeFromImage(Image, MemoryLimitKB, Error))
+    {
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Failed to create sandbox from image '%s': %s"), *ImageName.ToString(), *Error);
+        return nullptr;
+    }
+    GCSandboxes.Add(Box);
+    return Box;
+}
+
+bool ULuaRuntimeSubsystem::RemoveGoldenImage(const FName ImageName)
+{
+    return GoldenImages.Remove(ImageName) > 0;
+}
+
+TSharedPtr<const FLuaSandboxImage> ULuaRuntimeSubsystem::GetGoldenImage(const FName ImageName) const
+{
+    const TSharedPtr<const FLuaSandboxImage>* Found = GoldenImages.Find(ImageName);
+    return Found ? *Found : nullptr;
+}
+
+FLuaChunkCacheStats ULuaRuntimeSubsystem::GetChunkCacheStats() const
+{
+    return FLuaChunkCache::Get().GetStats();
+}
+
+void ULuaRuntimeSubsystem::ClearChunkCache()
+{
+    FLuaChunkCache::Get().Empty();
+}
+
+FLuaMemoryStats ULuaRuntimeSubsystem::GetTotalMemoryStats() const
+{
+    return ULuaSandbox::GetTotalMemoryStats();
+}
+
 bool ULuaRuntimeSubsystem::ValidateLuaSyntax(const FString& Code, FString& OutError) const
 {
     lua_State* L = luaL_newstate();
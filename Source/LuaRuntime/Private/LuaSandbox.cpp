@@ -1,10 +1,18 @@
 #include "LuaSandbox.h"
 #include "LuaRuntime.h"
+#include "LuaSandboxImage.h"
+#include "LuaChunkCache.h"
+#include "LuaAllocator.h"
+#include "LuaScript.h"
+#include "LuaTableRef.h"
+#include "LuaWatchdog.h"
+#include "Async/Async.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformTLS.h"
 #include "Misc/FileHelper.h"
+#include "UObject/StrongObjectPtr.h"
 #include "Engine/Engine.h" // GEngine->AddOnScreenDebugMessage
 #include "LuaRuntimeSettings.h"
-#include <cstdlib>
 
 // Lua headers (vendored under Private/ThirdParty/lua_slim/src)
 extern "C" {
@@ -15,71 +23,304 @@ extern "C" {
 
 namespace {
 
-struct FAllocatorState
+// Timeout and instruction budget state of the running call
+struct FHookState
 {
-    int64 LimitBytes = 0;
-    int64 UsedBytes = 0;
+    double StartTimeSec = 0.0;
+    int32 TimeoutMs = 0;
+    // Count hook interval when polling the clock (no watchdog); 0 when the watchdog enforces the deadline
+    int32 PollInterval = 0;
+    // Set by the watchdog thread when the deadline passes
+    std::atomic<bool> bTimedOut{false};
+    // Instructions the call may still run, as of the start of the current count hook cycle
+    bool bBudgeted = false;
+    int64 BudgetLeft = 0;
+    // Task slice: yield SliceThread instead of failing when the timeout or budget runs out
+    lua_State* SliceThread = nullptr;
+    // How long a slice may overrun while it cannot yield (e.g. inside a sort comparator) before it fails
+    int32 SliceGraceMs = 0;
 };
 
-static void* LuaCountingAllocator(void* ud, void* ptr, size_t osize, size_t nsize)
+static FHookState* GetHookState(lua_State* L)
+{
+    return *reinterpret_cast<FHookState**>(lua_getextraspace(L));
+}
+
+static bool HasDeadlinePassed(const FHookState* HS, double NowSec)
+{
+    return HS->TimeoutMs > 0 && (NowSec - HS->StartTimeSec) * 1000.0 > (double)HS->TimeoutMs;
+}
+
+static bool HasTimedOut(const FHookState* HS)
+{
+    return HS->TimeoutMs > 0 && (HS->bTimedOut.load() || HasDeadlinePassed(HS, FPlatformTime::Seconds()));
+}
+
+// Instructions counted so far in the current count hook cycle
+static int64 GetHookCycleCount(lua_State* L)
 {
-    FAllocatorState* State = reinterpret_cast<FAllocatorState*>(ud);
+    return lua_gethook(L) ? (int64)lua_gethookcount(L) - lua_gethookcountleft(L) : 0;
+}
 
-    // Adjust usage by the delta
-    int64 Delta = (int64)nsize - (int64)osize;
-    int64 NewUsed = State->UsedBytes + Delta;
+static void LuaHook(lua_State* L, lua_Debug* ar);
 
-    if (nsize != 0 && State->LimitBytes > 0 && NewUsed > State->LimitBytes)
+static void InstallHook(lua_State* L, const FHookState* HS)
+{
+    // The budget cycle ends one instruction past the budget, so exactly BudgetLeft instructions run
+    int64 Step = HS->PollInterval > 0 ? HS->PollInterval : MAX_int32;
+    if (HS->bBudgeted)
     {
-        // Allocation would exceed the cap
-        return nullptr;
+        Step = FMath::Clamp<int64>(HS->BudgetLeft + 1, 1, Step);
+    }
+
+    if (HS->PollInterval > 0 || HS->bBudgeted)
+    {
+        lua_sethook(L, &LuaHook, LUA_MASKCOUNT, (int)Step);
+    }
+    else
+    {
+        lua_sethook(L, nullptr, 0, 0);
     }
+}
 
-    // Perform the reallocation
-    void* NewPtr = nullptr;
-    if (nsize == 0)
+// Ends a task slice: the coroutine yields and continues from the same instruction on the next resume
+static void YieldFromHook(lua_State* L, FHookState* HS)
+{
+    // The instruction that tripped the hook runs (and is counted) after the resume
+    if (HS->bBudgeted)
     {
-        // Free
-        free(ptr);
-        NewPtr = nullptr;
+        ++HS->BudgetLeft;
     }
-    else if (ptr == nullptr)
+    lua_sethook(L, &LuaHook, LUA_MASKCOUNT, 1);
+    lua_yield(L, 0);
+}
+
+// Count hook (clock polling, instruction budget) and the state's interrupt hook (installed by the VM on lua_interrupt)
+static void LuaHook(lua_State* L, lua_Debug* /*ar*/)
+{
+    FHookState* HS = GetHookState(L);
+    if (!HS) return;
+
+    if (HS->bBudgeted)
     {
-        NewPtr = malloc(nsize);
+        HS->BudgetLeft -= lua_gethookcount(L);
     }
-    else
+    const bool bBudgetSpent = HS->bBudgeted && HS->BudgetLeft < 0;
+    // Read once: a slice that sees its deadline pass between two checks must still yield rather than fail
+    const bool bTimedOut = HasTimedOut(HS);
+
+    if (HS->SliceThread && (bBudgetSpent || bTimedOut))
+    {
+        // Only the task's own coroutine yields; a coroutine the script resumed itself would see a spurious yield
+        if (L == HS->SliceThread && lua_isyieldable(L))
+        {
+            YieldFromHook(L, HS);
+            return;
+        }
+        if ((FPlatformTime::Seconds() - HS->StartTimeSec) * 1000.0 <= (double)HS->TimeoutMs + HS->SliceGraceMs)
+        {
+            // Try again on the next instruction, once the non-yieldable call has returned
+            lua_sethook(L, &LuaHook, LUA_MASKCOUNT, 1);
+            return;
+        }
+        lua_sethook(L, &LuaHook, LUA_MASKCOUNT, 1);
+        luaL_error(L, "execution timed out");
+    }
+
+    if (bBudgetSpent)
     {
-        NewPtr = realloc(ptr, nsize);
+        // The instruction that tripped the hook does not run; a script catching the error fails again on the next one
+        HS->BudgetLeft = 0;
+        lua_sethook(L, &LuaHook, LUA_MASKCOUNT, 1);
+        luaL_error(L, "instruction budget exceeded");
     }
 
-    if (NewPtr || nsize == 0)
+    if (bTimedOut)
     {
-        State->UsedBytes = NewUsed;
+        lua_sethook(L, &LuaHook, LUA_MASKCOUNT, 1);
+        luaL_error(L, "execution timed out");
     }
-    return NewPtr;
+
+    // Next polling/budget cycle; also drops an interrupt that no longer applies
+    InstallHook(L, HS);
 }
 
-// Wall-clock timeout via instruction hook
-struct FHookState
+// Negative budgets defer to the project default; 0 means unlimited
+static int64 ResolveInstructionBudget(int64 Budget, int64 Default)
 {
-    double StartTimeSec = 0.0;
-    int32 TimeoutMs = 0;
+    return Budget >= 0 ? Budget : FMath::Max<int64>(Default, 0);
+}
+
+// Arms the timeout and instruction budget of one protected call and tears them down afterwards. The watchdog
+// thread enforces the deadline when enabled; otherwise a count hook polls the clock every HookInterval instructions.
+// A call re-entering the same sandbox (through a callback) restores the outer call's state when it ends and
+// charges its instructions to the outer budget. With a SliceThread, TimeoutMs is the slice length.
+struct FHookScope
+{
+    FHookScope(lua_State* InL, int32 TimeoutMs, int32 HookInterval, int64 InstructionBudget, lua_State* SliceThread, int64& OutExecuted)
+        : L(InL)
+        , HS(GetHookState(InL))
+        , Executed(OutExecuted)
+        , Budget(InstructionBudget)
+        , OuterStartTimeSec(HS->StartTimeSec)
+        , OuterTimeoutMs(HS->TimeoutMs)
+        , OuterPollInterval(HS->PollInterval)
+        , bOuterBudgeted(HS->bBudgeted)
+        , OuterBudgetLeft(HS->BudgetLeft - (HS->bBudgeted ? GetHookCycleCount(InL) : 0))
+        , OuterSliceThread(HS->SliceThread)
+        , OuterSliceGraceMs(HS->SliceGraceMs)
+    {
+        const double Now = FPlatformTime::Seconds();
+        HS->StartTimeSec = Now;
+        HS->TimeoutMs = TimeoutMs;
+        HS->PollInterval = 0;
+        HS->bTimedOut.store(false);
+        HS->bBudgeted = Budget >= 0;
+        HS->BudgetLeft = FMath::Max<int64>(Budget, 0);
+        HS->SliceThread = SliceThread;
+        HS->SliceGraceMs = 0;
+
+        const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+        if (SliceThread)
+        {
+            HS->SliceGraceMs = Settings ? Settings->DefaultTimeoutMs : 50;
+        }
+        if (TimeoutMs > 0)
+        {
+            if (!Settings || Settings->bUseWatchdogTimeouts)
+            {
+                Ticket = FLuaWatchdog::Get().Arm(L, Now + TimeoutMs / 1000.0, &HS->bTimedOut);
+            }
+            if (Ticket == 0)
+            {
+                HS->PollInterval = FMath::Max(1, HookInterval);
+            }
+        }
+        InstallHook(L, HS);
+    }
+
+    ~FHookScope()
+    {
+        if (Ticket != 0)
+        {
+            FLuaWatchdog::Get().Disarm(Ticket);
+        }
+
+        // A slice that could not yield right away may have overrun its budget
+        Executed = HS->bBudgeted ? Budget - (HS->BudgetLeft - GetHookCycleCount(L)) : 0;
+
+        HS->StartTimeSec = OuterStartTimeSec;
+        HS->TimeoutMs = OuterTimeoutMs;
+        HS->PollInterval = OuterPollInterval;
+        HS->bBudgeted = bOuterBudgeted;
+        HS->BudgetLeft = OuterBudgetLeft - Executed;
+        HS->SliceThread = OuterSliceThread;
+        HS->SliceGraceMs = OuterSliceGraceMs;
+        InstallHook(L, HS);
+
+        // An outer deadline may have expired while the nested call ran; make sure it still triggers
+        if (HasDeadlinePassed(HS, FPlatformTime::Seconds()))
+        {
+            HS->bTimedOut.store(true);
+            lua_interrupt(L);
+        }
+        else
+        {
+            HS->bTimedOut.store(false);
+            lua_clearinterrupt(L);
+        }
+    }
+
+    lua_State* L;
+    FHookState* HS;
+    int64& Executed;
+    int64 Budget;
+    double OuterStartTimeSec;
+    int32 OuterTimeoutMs;
+    int32 OuterPollInterval;
+    bool bOuterBudgeted;
+    int64 OuterBudgetLeft;
+    lua_State* OuterSliceThread;
+    int32 OuterSliceGraceMs;
+    uint64 Ticket = 0;
 };
 
-static void HookTimeout(lua_State* L)
+// True when the table at absIndex only has integer keys 1..N (N = raw length).
+static bool IsArrayLikeTable(lua_State* L, int absIndex, lua_Integer& OutLen, int32& OutCount)
 {
-    FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-    if (!HS || HS->TimeoutMs <= 0) return;
-    const double ElapsedMs = (FPlatformTime::Seconds() - HS->StartTimeSec) * 1000.0;
-    if (ElapsedMs > (double)HS->TimeoutMs)
+    const lua_Integer rawLen = (lua_Integer)lua_rawlen(L, absIndex);
+    bool bArrayCandidate = true;
+    int32 Count = 0;
+
+    lua_pushnil(L);
+    while (lua_next(L, absIndex) != 0)
     {
-        luaL_error(L, "execution timed out");
+        // stack: ... key value
+        if (lua_type(L, -2) == LUA_TNUMBER)
+        {
+            lua_Number n = lua_tonumber(L, -2);
+            lua_Integer i;
+            if (modf(n, &n) != 0.0) // non-integer
+            {
+                bArrayCandidate = false;
+            }
+            else
+            {
+                i = (lua_Integer)lua_tointeger(L, -2);
+                if (i < 1 || i > rawLen)
+                {
+                    bArrayCandidate = false;
+                }
+            }
+        }
+        else
+        {
+            bArrayCandidate = false;
+        }
+        Count++;
+        lua_pop(L, 1); // pop value, keep key for next lua_next
     }
+
+    OutLen = rawLen;
+    OutCount = Count;
+    return bArrayCandidate && Count == rawLen;
 }
 
-static void LuaHook(lua_State* L, lua_Debug* /*ar*/)
+// Stringify a table key for the FString-keyed value representations.
+static FString LuaKeyToString(lua_State* L, int Index)
+{
+    const int absIndex = lua_absindex(L, Index);
+    switch (lua_type(L, absIndex))
+    {
+    case LUA_TSTRING:
+    {
+        size_t klen = 0; const char* ks = lua_tolstring(L, absIndex, &klen);
+        return FString(klen, UTF8_TO_TCHAR(ks));
+    }
+    case LUA_TNUMBER:
+        return FString::SanitizeFloat(lua_tonumber(L, absIndex));
+    case LUA_TBOOLEAN:
+        return lua_toboolean(L, absIndex) ? TEXT("true") : TEXT("false");
+    default:
+    {
+        // Fallback to tostring for complex keys
+        size_t klen = 0; const char* ks = luaL_tolstring(L, absIndex, &klen);
+        FString KeyStr(klen, UTF8_TO_TCHAR(ks));
+        lua_pop(L, 1); // pop tostring result
+        return KeyStr;
+    }
+    }
+}
+
+// Element Index of a typed buffer (see luaL_tobuffer) as a number
+static double GetBufferElement(const void* Data, int Type, size_t Index)
 {
-    HookTimeout(L);
+    switch (Type)
+    {
+    case LUA_BUFF32: return static_cast<const float*>(Data)[Index];
+    case LUA_BUFF64: return static_cast<const double*>(Data)[Index];
+    default: return static_cast<const int32*>(Data)[Index];
+    }
 }
 
 // Recursively convert a Lua value at a given index to FLuaDynValue.
@@ -102,6 +343,11 @@ static void ConvertLuaToDynValue(lua_State* L, int Index, FLuaDynValue& Out, ULu
         size_t len = 0; const char* s = lua_tolstring(L, absIndex, &len);
         Out.Type = ELuaType::String; Out.String = FString(len, UTF8_TO_TCHAR(s)); return;
     }
+    case LUA_TVECTOR:
+    {
+        lua_Number v[3]; lua_tovector(L, absIndex, v);
+        Out.Type = ELuaType::Vector; Out.Vector = FVector(v[0], v[1], v[2]); return;
+    }
     case LUA_TTABLE:
     {
         Out.Type = ELuaType::Table;
@@ -120,40 +366,9 @@ static void ConvertLuaToDynValue(lua_State* L, int Index, FLuaDynValue& Out, ULu
         }
         Visited->Add(Ptr);
 
-        const lua_Integer rawLen = (lua_Integer)lua_rawlen(L, absIndex);
-        bool bArrayCandidate = true;
+        lua_Integer rawLen = 0;
         int32 Count = 0;
-
-        lua_pushnil(L);
-        while (lua_next(L, absIndex) != 0)
-        {
-            // stack: ... key value
-            if (lua_type(L, -2) == LUA_TNUMBER)
-            {
-                lua_Number n = lua_tonumber(L, -2);
-                lua_Integer i;
-                if (modf(n, &n) != 0.0) // non-integer
-                {
-                    bArrayCandidate = false;
-                }
-                else
-                {
-                    i = (lua_Integer)lua_tointeger(L, -2);
-                    if (i < 1 || i > rawLen)
-                    {
-                        bArrayCandidate = false;
-                    }
-                }
-            }
-            else
-            {
-                bArrayCandidate = false;
-            }
-            Count++;
-            lua_pop(L, 1); // pop value, keep key for next lua_next
-        }
-
-        if (bArrayCandidate && Count == rawLen)
+        if (IsArrayLikeTable(L, absIndex, rawLen, Count))
         {
             Out.Type = ELuaType::Array;
             Out.Array.Reserve((int32)rawLen);
@@ -169,40 +384,12 @@ static void ConvertLuaToDynValue(lua_State* L, int Index, FLuaDynValue& Out, ULu
         else
         {
             Out.Type = ELuaType::Table;
-            Out.Table.Empty();
+            Out.Table.Empty(Count);
             lua_pushnil(L);
             while (lua_next(L, absIndex) != 0)
             {
                 // key at -2, value at -1
-                FString KeyStr;
-                int kt = lua_type(L, -2);
-                switch (kt)
-                {
-                case LUA_TSTRING:
-                {
-                    size_t klen = 0; const char* ks = lua_tolstring(L, -2, &klen);
-                    KeyStr = FString(klen, UTF8_TO_TCHAR(ks));
-                    break;
-                }
-                case LUA_TNUMBER:
-                {
-                    lua_Number kn = lua_tonumber(L, -2);
-                    KeyStr = FString::SanitizeFloat(kn);
-                    break;
-                }
-                case LUA_TBOOLEAN:
-                    KeyStr = lua_toboolean(L, -2) ? TEXT("true") : TEXT("false");
-                    break;
-                default:
-                {
-                    // Fallback to tostring for complex keys
-                    size_t klen = 0; const char* ks = luaL_tolstring(L, -2, &klen);
-                    KeyStr = FString(klen, UTF8_TO_TCHAR(ks));
-                    lua_pop(L, 1); // pop tostring result
-                    break;
-                }
-                }
-
+                FString KeyStr = LuaKeyToString(L, -2);
                 ULuaValueObject* ChildObj = NewObject<ULuaValueObject>(Owner);
                 ConvertLuaToDynValue(L, -1, ChildObj->Value, Owner, Depth + 1, MaxDepth, Visited);
                 Out.Table.Add(MoveTemp(KeyStr), ChildObj);
@@ -213,11 +400,146 @@ static void ConvertLuaToDynValue(lua_State* L, int Index, FLuaDynValue& Out, ULu
         Visited->Remove(Ptr);
         return;
     }
+    case LUA_TUSERDATA:
+    {
+        // Typed buffers read as arrays of numbers; other userdata has no value form
+        int BufferType = 0; size_t Num = 0;
+        const void* Data = luaL_tobuffer(L, absIndex, &BufferType, &Num);
+        Out.Type = Data ? ELuaType::Array : ELuaType::Nil;
+        if (Data)
+        {
+            Out.Array.Reserve((int32)Num);
+            for (size_t i = 0; i < Num; ++i)
+            {
+                ULuaValueObject* ElemObj = NewObject<ULuaValueObject>(Owner);
+                ElemObj->Value.Type = ELuaType::Number;
+                ElemObj->Value.Number = GetBufferElement(Data, BufferType, i);
+                Out.Array.Add(ElemObj);
+            }
+        }
+        return;
+    }
     default:
         Out.Type = ELuaType::Nil; return;
     }
 }
 
+// Convert the Lua value at Index into Out.Nodes[NodeIndex]. Same rules as ConvertLuaToDynValue,
+// but children are appended as a contiguous block of nodes instead of allocating ULuaValueObjects.
+static void ConvertLuaToFlatValue(lua_State* L, int Index, FLuaFlatValue& Out, int32 NodeIndex, int Depth, TSet<const void*>& Visited)
+{
+    static constexpr int MaxDepth = 32;
+    const int absIndex = lua_absindex(L, Index);
+
+    // Out.Nodes may grow while children are converted; always go through NodeIndex
+    switch (lua_type(L, absIndex))
+    {
+    case LUA_TBOOLEAN:
+        Out.Nodes[NodeIndex].Type = ELuaType::Boolean;
+        Out.Nodes[NodeIndex].Boolean = lua_toboolean(L, absIndex) != 0;
+        return;
+    case LUA_TNUMBER:
+        Out.Nodes[NodeIndex].Type = ELuaType::Number;
+        Out.Nodes[NodeIndex].Number = lua_tonumber(L, absIndex);
+        return;
+    case LUA_TSTRING:
+    {
+        size_t len = 0; const char* s = lua_tolstring(L, absIndex, &len);
+        Out.Nodes[NodeIndex].Type = ELuaType::String;
+        Out.Nodes[NodeIndex].String = FString(len, UTF8_TO_TCHAR(s));
+        return;
+    }
+    case LUA_TVECTOR:
+    {
+        lua_Number v[3]; lua_tovector(L, absIndex, v);
+        Out.Nodes[NodeIndex].Type = ELuaType::Vector;
+        Out.Nodes[NodeIndex].Vector = FVector(v[0], v[1], v[2]);
+        return;
+    }
+    case LUA_TTABLE:
+    {
+        Out.Nodes[NodeIndex].Type = ELuaType::Table;
+        const void* Ptr = lua_topointer(L, absIndex);
+        if (Depth >= MaxDepth || Visited.Contains(Ptr))
+        {
+            // Depth cap or cycle; leave as an empty table
+            return;
+        }
+        Visited.Add(Ptr);
+
+        lua_Integer rawLen = 0;
+        int32 Count = 0;
+        const bool bArray = IsArrayLikeTable(L, absIndex, rawLen, Count);
+        if (Count > 0)
+        {
+            const int32 First = Out.Nodes.AddDefaulted(Count);
+            Out.Nodes[NodeIndex].FirstChild = First;
+            Out.Nodes[NodeIndex].NumChildren = Count;
+
+            if (bArray)
+            {
+                Out.Nodes[NodeIndex].Type = ELuaType::Array;
+                for (lua_Integer i = 1; i <= rawLen; ++i)
+                {
+                    lua_geti(L, absIndex, i);
+                    ConvertLuaToFlatValue(L, -1, Out, First + (int32)(i - 1), Depth + 1, Visited);
+                    lua_pop(L, 1);
+                }
+            }
+            else
+            {
+                int32 Child = First;
+                lua_pushnil(L);
+                while (lua_next(L, absIndex) != 0)
+                {
+                    Out.Nodes[Child].Key = LuaKeyToString(L, -2);
+                    ConvertLuaToFlatValue(L, -1, Out, Child, Depth + 1, Visited);
+                    lua_pop(L, 1); // pop value
+                    ++Child;
+                }
+            }
+        }
+        else if (bArray)
+        {
+            // Match ConvertLuaToDynValue: an empty table is reported as an empty array
+            Out.Nodes[NodeIndex].Type = ELuaType::Array;
+        }
+
+        Visited.Remove(Ptr);
+        return;
+    }
+    case LUA_TUSERDATA:
+    {
+        int BufferType = 0; size_t Num = 0;
+        const void* Data = luaL_tobuffer(L, absIndex, &BufferType, &Num);
+        Out.Nodes[NodeIndex].Type = Data ? ELuaType::Array : ELuaType::Nil;
+        if (Data && Num > 0)
+        {
+            const int32 First = Out.Nodes.AddDefaulted((int32)Num);
+            Out.Nodes[NodeIndex].FirstChild = First;
+            Out.Nodes[NodeIndex].NumChildren = (int32)Num;
+            for (size_t i = 0; i < Num; ++i)
+            {
+                Out.Nodes[First + (int32)i].Type = ELuaType::Number;
+                Out.Nodes[First + (int32)i].Number = GetBufferElement(Data, BufferType, i);
+            }
+        }
+        return;
+    }
+    default:
+        Out.Nodes[NodeIndex].Type = ELuaType::Nil;
+        return;
+    }
+}
+
+static void ReadLuaFlatValue(lua_State* L, int Index, FLuaFlatValue& Out)
+{
+    Out.Nodes.Reset();
+    Out.Nodes.AddDefaulted();
+    TSet<const void*> Visited;
+    ConvertLuaToFlatValue(L, Index, Out, FLuaFlatValue::RootIndex, 0, Visited);
+}
+
 static int LuaPrint(lua_State* L)
 {
     int nargs = lua_gettop(L);
@@ -236,7 +558,8 @@ static int LuaPrint(lua_State* L)
     }
     UE_LOG(LogLuaRuntime, Log, TEXT("[lua] %s"), *Out);
 
-    if (GEngine)
+    // On-screen messages are game thread only; async work just logs
+    if (GEngine && IsInGameThread())
     {
         const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
         bool bAllowOnScreen = Settings && Settings->bOnScreenPrintEnabled;
@@ -253,69 +576,411 @@ static int LuaPrint(lua_State* L)
     return 0;
 }
 
-// Helper: set global string from UTF-16
-static void PushFString(lua_State* L, const FString& Str)
-{
-    FTCHARToUTF8 Convert(*Str);
-    lua_pushlstring(L, Convert.Get(), Convert.Length());
-}
-
-}
+// Baseline snapshot used to reset pooled sandboxes.
+// Stored in the registry as a list of { LiveTable, ShallowCopy, Metatable } entries.
+static const char* const BaselineRegistryKey = "LuaRuntime.Baseline";
 
-ULuaSandbox::ULuaSandbox()
+static void PushShallowCopy(lua_State* L, int Index)
 {
+    Index = lua_absindex(L, Index);
+    lua_newtable(L);
+    lua_pushnil(L);
+    while (lua_next(L, Index) != 0)
+    {
+        // stack: ... copy key value
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, -4);
+    }
 }
 
-void ULuaSandbox::BeginDestroy()
+static void AddBaselineEntry(lua_State* L, int ListIndex, int Index)
 {
-    Close();
-    Super::BeginDestroy();
+    Index = lua_absindex(L, Index);
+    lua_createtable(L, 3, 0);
+    lua_pushvalue(L, Index);
+    lua_rawseti(L, -2, 1);
+    PushShallowCopy(L, Index);
+    lua_rawseti(L, -2, 2);
+    if (lua_getmetatable(L, Index))
+    {
+        lua_rawseti(L, -2, 3);
+    }
+    lua_rawseti(L, ListIndex, (lua_Integer)lua_rawlen(L, ListIndex) + 1);
 }
 
-void* ULuaSandbox::CreateState(int32 MemoryLimitKB)
+static int SaveBaselineImpl(lua_State* L)
 {
-    check(L == nullptr);
-    AllocLimitBytes = (int64)MemoryLimitKB * 1024;
+    lua_newtable(L);
+    const int List = lua_gettop(L);
 
-    // Hook state pointer stored in extraspace
-    // Allocator state lives separately
-    FAllocatorState* AllocState = new FAllocatorState();
-    AllocState->LimitBytes = AllocLimitBytes;
-    AllocState->UsedBytes = 0;
+    lua_pushglobaltable(L);
+    AddBaselineEntry(L, List, -1);
 
-    lua_State* NewL = lua_newstate(&LuaCountingAllocator, AllocState);
-    if (!NewL)
+    // Library tables (string, math, ...) one level below _G
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0)
     {
-        delete AllocState;
-        return nullptr;
+        // stack: list _G key value
+        if (lua_istable(L, -1) && !lua_rawequal(L, -1, -3))
+        {
+            AddBaselineEntry(L, List, -1);
+        }
+        lua_pop(L, 1);
     }
+    lua_pop(L, 1);
 
-    // Panic handler: turn panic into UE log and close
-    lua_atpanic(NewL, [](lua_State* LL) -> int {
-        const char* msg = lua_tostring(LL, -1);
-        UE_LOG(LogLuaRuntime, Error, TEXT("Lua panic: %s"), msg ? UTF8_TO_TCHAR(msg) : TEXT("<null>"));
-        return 0;
-    });
-
-    // Initialize hook state pointer in extraspace
-    FHookState* HS = new FHookState();
-    HS->StartTimeSec = 0.0;
-    HS->TimeoutMs = 0;
-    *reinterpret_cast<FHookState**>(lua_getextraspace(NewL)) = HS;
+    // Shared string metatable (string methods via ("x"):upper())
+    lua_pushliteral(L, "");
+    if (lua_getmetatable(L, -1))
+    {
+        AddBaselineEntry(L, List, -1);
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
 
-    return NewL;
-}
+    // Shared vector metatable (reachable through getmetatable(vector.zero))
+    lua_pushvector(L, 0, 0, 0);
+    if (lua_getmetatable(L, -1))
+    {
+        AddBaselineEntry(L, List, -1);
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
 
-void ULuaSandbox::OpenSafeLibs()
+    // Buffer metatable (reachable through getmetatable of any buffer)
+    if (luaL_getmetatable(L, LUA_BUFFERHANDLE) == LUA_TTABLE)
+    {
+        AddBaselineEntry(L, List, -1);
+    }
+    lua_pop(L, 1);
+
+    lua_setfield(L, LUA_REGISTRYINDEX, BaselineRegistryKey);
+    return 0;
+}
+
+static int RestoreBaselineImpl(lua_State* L)
+{
+    if (lua_getfield(L, LUA_REGISTRYINDEX, BaselineRegistryKey) != LUA_TTABLE)
+    {
+        return luaL_error(L, "no baseline saved");
+    }
+    const int List = lua_gettop(L);
+    const lua_Integer Count = (lua_Integer)lua_rawlen(L, List);
+    for (lua_Integer i = 1; i <= Count; ++i)
+    {
+        lua_rawgeti(L, List, i);
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        const int Live = lua_gettop(L) - 1;
+        const int Copy = Live + 1;
+
+        // Drop keys that were added after the baseline
+        lua_pushnil(L);
+        while (lua_next(L, Live) != 0)
+        {
+            lua_pop(L, 1);
+            lua_pushvalue(L, -1);
+            if (lua_rawget(L, Copy) == LUA_TNIL)
+            {
+                lua_pushvalue(L, -2);
+                lua_pushnil(L);
+                lua_rawset(L, Live);
+            }
+            lua_pop(L, 1);
+        }
+
+        // Put back baseline values (also re-adds removed keys)
+        lua_pushnil(L);
+        while (lua_next(L, Copy) != 0)
+        {
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, Live);
+        }
+
+        lua_rawgeti(L, -3, 3); // metatable or nil
+        lua_setmetatable(L, Live);
+        lua_pop(L, 3);
+    }
+
+    // math.random keeps its generator state in an upvalue the table restore cannot reach; reseed it (randomly, as a
+    // fresh state would be) so a seed the previous script set does not make the next one predictable
+    const int Top = lua_gettop(L);
+    lua_pushglobaltable(L);
+    if (lua_getfield(L, -1, LUA_MATHLIBNAME) == LUA_TTABLE && lua_getfield(L, -1, "randomseed") == LUA_TFUNCTION)
+    {
+        lua_call(L, 0, 0);
+    }
+    lua_settop(L, Top);
+
+    // Drop every luaL_ref handle (integer registry keys past the predefined slots)
+    lua_pushnil(L);
+    while (lua_next(L, LUA_REGISTRYINDEX) != 0)
+    {
+        lua_pop(L, 1);
+        if (lua_isinteger(L, -1) && lua_tointeger(L, -1) > LUA_RIDX_LAST)
+        {
+            lua_pushvalue(L, -1);
+            lua_pushnil(L);
+            lua_rawset(L, LUA_REGISTRYINDEX);
+        }
+    }
+    return 0;
+}
+
+// Live closures of Bind, keyed by their binding (light userdata). Values are weak, so the table only tracks closures
+// scripts still reach; a binding is detached from its closure before it is freed.
+static const char* const BindingsRegistryKey = "LuaRuntime.Bindings";
+
+static void PushBindingClosures(lua_State* L)
+{
+    if (lua_getfield(L, LUA_REGISTRYINDEX, BindingsRegistryKey) == LUA_TTABLE)
+    {
+        return;
+    }
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_createtable(L, 0, 1);
+    lua_pushliteral(L, "v");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, BindingsRegistryKey);
+}
+
+// Clear the binding upvalue of the closure at the top of the stack; calls then raise "not bound" instead of
+// reaching freed memory
+static void DetachBindingClosure(lua_State* L)
+{
+    if (lua_iscfunction(L, -1))
+    {
+        lua_pushnil(L);
+        lua_setupvalue(L, -2, 1);
+    }
+}
+
+static int ToLuaBufferType(ELuaBufferType Type)
+{
+    switch (Type)
+    {
+    case ELuaBufferType::Float: return LUA_BUFF32;
+    case ELuaBufferType::Double: return LUA_BUFF64;
+    default: return LUA_BUFI32;
+    }
+}
+
+// Protected so that hitting the memory limit raises a Lua error instead of a panic.
+// Arguments: element type, count, global name. Returns the buffer's storage as light userdata.
+static int NewGlobalBufferImpl(lua_State* L)
+{
+    void* Data = luaL_newbuffer(L, (int)lua_tointeger(L, 1), (size_t)lua_tointeger(L, 2));
+    lua_setglobal(L, lua_tostring(L, 3));
+    lua_pushlightuserdata(L, Data);
+    return 1;
+}
+
+// Helper: set global string from UTF-16
+static void PushFString(lua_State* L, const FString& Str)
+{
+    FTCHARToUTF8 Convert(*Str);
+    lua_pushlstring(L, Convert.Get(), Convert.Length());
+}
+
+static void PushValue(lua_State* L, const FLuaValue& Value)
+{
+    if (Value.bIsNil)
+    {
+        lua_pushnil(L);
+    }
+    else if (!Value.StringValue.IsEmpty())
+    {
+        PushFString(L, Value.StringValue);
+    }
+    else if (Value.BoolValue)
+    {
+        lua_pushboolean(L, 1);
+    }
+    else
+    {
+        lua_pushnumber(L, Value.NumberValue);
+    }
+}
+
+// Overwrites Out in place; a string reuses Out.StringValue's buffer when it is large enough
+static void ReadLuaValue(lua_State* L, int Index, FLuaValue& Out)
+{
+    Out.StringValue.Reset();
+    Out.NumberValue = 0.0;
+    Out.BoolValue = false;
+    Out.bIsNil = false;
+
+    switch (lua_type(L, Index))
+    {
+    case LUA_TBOOLEAN:
+        Out.BoolValue = lua_toboolean(L, Index) != 0;
+        break;
+    case LUA_TNUMBER:
+        Out.NumberValue = lua_tonumber(L, Index);
+        break;
+    case LUA_TSTRING:
+        {
+            size_t Len = 0;
+            const char* Str = lua_tolstring(L, Index, &Len);
+            FUTF8ToTCHAR Convert(Str, (int32)Len);
+            Out.StringValue.AppendChars(Convert.Get(), Convert.Length());
+        }
+        break;
+    default:
+        Out.bIsNil = true;
+        break;
+    }
+}
+
+}
+
+namespace {
+
+// Counters of every live sandbox; the lock guards only the list, never the allocation path
+FCriticalSection GMemoryCountersLock;
+TArray<TSharedPtr<FLuaMemoryCounters, ESPMode::ThreadSafe>> GMemoryCounters;
+
+static void OpenSafeLibraries(lua_State* State)
+{
+    luaL_requiref(State, LUA_GNAME, luaopen_base, 1);  lua_pop(State, 1);
+    luaL_requiref(State, LUA_TABLIBNAME, luaopen_table, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_STRLIBNAME, luaopen_string, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_MATHLIBNAME, luaopen_math, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_UTF8LIBNAME, luaopen_utf8, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_COLIBNAME, luaopen_coroutine, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_VECLIBNAME, luaopen_vector, 1); lua_pop(State, 1);
+    luaL_requiref(State, LUA_BUFLIBNAME, luaopen_buffer, 1); lua_pop(State, 1);
+}
+
+// Short strings of a freshly opened sandbox (library and metamethod names, reserved words), interned once and
+// searched read-only by every state created afterwards instead of being hashed and allocated in each. Built on first
+// use and never freed, since open states point into it.
+static const lua_SharedStrings* GetSharedStrings()
+{
+    static const lua_SharedStrings* Shared = []() -> const lua_SharedStrings*
+    {
+        lua_State* Boot = luaL_newstate();
+        if (!Boot)
+        {
+            return nullptr;
+        }
+        OpenSafeLibraries(Boot);
+        lua_gc(Boot, LUA_GCCOLLECT, 0);
+
+        const size_t Size = lua_sharedstringssize(Boot);
+        void* Block = FMemory::Malloc(Size);
+        const lua_SharedStrings* Strings = lua_buildsharedstrings(Boot, Block, Size);
+        lua_close(Boot);
+        if (!Strings)
+        {
+            FMemory::Free(Block);
+            return nullptr;
+        }
+        UE_LOG(LogLuaRuntime, Verbose, TEXT("Shared Lua string table: %llu bytes"), (uint64)Size);
+        return Strings;
+    }();
+    return Shared;
+}
+
+}
+
+ULuaSandbox::ULuaSandbox()
+    : MemoryCounters(MakeShared<FLuaMemoryCounters, ESPMode::ThreadSafe>())
+{
+    if (!HasAnyFlags(RF_ClassDefaultObject))
+    {
+        FScopeLock Lock(&GMemoryCountersLock);
+        GMemoryCounters.Add(MemoryCounters);
+    }
+}
+
+void ULuaSandbox::BeginDestroy()
+{
+    Close();
+    {
+        FScopeLock Lock(&GMemoryCountersLock);
+        GMemoryCounters.RemoveSwap(MemoryCounters);
+    }
+    Super::BeginDestroy();
+}
+
+void* ULuaSandbox::CreateState(int32 MemoryLimitKB, bool bUseArena)
+{
+    check(L == nullptr);
+    AllocLimitBytes = (int64)MemoryLimitKB * 1024;
+    MemoryCounters->Reset();
+
+    // Hook state pointer stored in extraspace
+    // Allocator state lives separately
+    FLuaAllocator* Allocator = nullptr;
+    if (bUseArena)
+    {
+        Allocator = FLuaAllocator::CreateArena(AllocLimitBytes, FLuaAllocator::GetArenaBytesForLimit(AllocLimitBytes), *MemoryCounters);
+    }
+    else
+    {
+        const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+        const bool bUseSmallObjectPool = !Settings || Settings->bUseSmallObjectPool;
+        Allocator = new FLuaAllocator(AllocLimitBytes, bUseSmallObjectPool, *MemoryCounters);
+    }
+    bArena = Allocator->IsArena();
+
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    const lua_SharedStrings* SharedStrings = (!Settings || Settings->bShareInternedStrings) ? GetSharedStrings() : nullptr;
+    lua_State* NewL = lua_newsharedstate(&FLuaAllocator::LuaAlloc, Allocator, SharedStrings);
+    if (!NewL)
+    {
+        delete Allocator;
+        return nullptr;
+    }
+
+    // Panic handler: turn panic into UE log and close
+    lua_atpanic(NewL, [](lua_State* LL) -> int {
+        const char* msg = lua_tostring(LL, -1);
+        UE_LOG(LogLuaRuntime, Error, TEXT("Lua panic: %s"), msg ? UTF8_TO_TCHAR(msg) : TEXT("<null>"));
+        return 0;
+    });
+
+    // Initialize hook state pointer in extraspace
+    FHookState* HS = new FHookState();
+    HS->StartTimeSec = 0.0;
+    HS->TimeoutMs = 0;
+    *reinterpret_cast<FHookState**>(lua_getextraspace(NewL)) = HS;
+    lua_setinterrupt(NewL, &LuaHook);
+    ApplyGCMode(NewL);
+
+    return NewL;
+}
+
+// Lua's built-in collector parameters (lgc.h), used to undo SetIncrementalGC/SetGenerationalGC
+static constexpr int LuaDefaultGCPause = 200;
+static constexpr int LuaDefaultGCStepMul = 100;
+static constexpr int LuaDefaultGCStepSizeLog2 = 13;
+static constexpr int LuaDefaultGenMinorMul = 20;
+static constexpr int LuaDefaultGenMajorMul = 100;
+
+void ULuaSandbox::ApplyGCMode(lua_State* State) const
+{
+    if (GCMode == ELuaGCMode::Generational)
+    {
+        lua_gc(State, LUA_GCGEN, GCParams[0], GCParams[1]);
+    }
+    else
+    {
+        lua_gc(State, LUA_GCINC, GCParams[0], GCParams[1], GCParams[2]);
+    }
+}
+
+void ULuaSandbox::OpenSafeLibs()
 {
     check(L);
     // Open only safe libs
-    luaL_requiref(L, LUA_GNAME, luaopen_base, 1);  lua_pop(L, 1);
-    luaL_requiref(L, LUA_TABLIBNAME, luaopen_table, 1); lua_pop(L, 1);
-    luaL_requiref(L, LUA_STRLIBNAME, luaopen_string, 1); lua_pop(L, 1);
-    luaL_requiref(L, LUA_MATHLIBNAME, luaopen_math, 1); lua_pop(L, 1);
-    luaL_requiref(L, LUA_UTF8LIBNAME, luaopen_utf8, 1); lua_pop(L, 1);
-    luaL_requiref(L, LUA_COLIBNAME, luaopen_coroutine, 1); lua_pop(L, 1);
+    OpenSafeLibraries(L);
 
     RemoveUnsafeBaseFuncs();
     InstallPrint();
@@ -328,86 +993,534 @@ void ULuaSandbox::RemoveUnsafeBaseFuncs()
     lua_pushnil(L); lua_setglobal(L, "loadfile");
     lua_pushnil(L); lua_setglobal(L, "load");
 
-    // Also remove string.dump (generates binary chunks)
-    lua_getglobal(L, "string");
-    if (lua_istable(L, -1))
+    // Also remove string.dump (generates binary chunks)
+    lua_getglobal(L, "string");
+    if (lua_istable(L, -1))
+    {
+        lua_pushnil(L);
+        lua_setfield(L, -2, "dump");
+    }
+    lua_pop(L, 1);
+}
+
+void ULuaSandbox::InstallPrint()
+{
+    lua_pushcfunction(L, &LuaPrint);
+    lua_setglobal(L, "print");
+}
+
+void ULuaSandbox::Initialize(int32 MemoryLimitKB)
+{
+    if (L)
+    {
+        Close();
+    }
+    L = static_cast<lua_State*>(CreateState(MemoryLimitKB));
+    if (L)
+    {
+        OpenSafeLibs();
+    }
+}
+
+void ULuaSandbox::InitializeArena(int32 MemoryLimitKB)
+{
+    if (L)
+    {
+        Close();
+    }
+    if (MemoryLimitKB <= 0)
+    {
+        // An arena needs a bound; fall back to the regular allocator
+        UE_LOG(LogLuaRuntime, Warning, TEXT("InitializeArena requires a memory limit; using the regular allocator"));
+        Initialize(MemoryLimitKB);
+        return;
+    }
+    L = static_cast<lua_State*>(CreateState(MemoryLimitKB, true));
+    if (L)
+    {
+        OpenSafeLibs();
+    }
+}
+
+bool ULuaSandbox::InitializeFromImage(const TSharedPtr<const FLuaSandboxImage>& Image, int32 MemoryLimitKB, FString& OutError)
+{
+    if (!Image.IsValid())
+    {
+        OutError = TEXT("Invalid sandbox image");
+        return false;
+    }
+    if (L)
+    {
+        Close();
+    }
+    L = static_cast<lua_State*>(CreateState(MemoryLimitKB));
+    if (!L)
+    {
+        OutError = TEXT("Failed to create Lua state");
+        return false;
+    }
+    if (!Image->Instantiate(L, OutError))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+TSharedPtr<const FLuaSandboxImage> ULuaSandbox::CaptureImage(FString& OutError) const
+{
+    if (!IsStateAvailable(&OutError))
+    {
+        return nullptr;
+    }
+    return FLuaSandboxImage::Capture(L, OutError);
+}
+
+void ULuaSandbox::Close()
+{
+    // Queued async work still needs the state
+    WaitForAsync();
+
+    if (L)
+    {
+        // Free hook state pointer first
+        FHookState* HS = GetHookState(L);
+        delete HS;
+        *reinterpret_cast<FHookState**>(lua_getextraspace(L)) = nullptr;
+
+        void* UD = nullptr;
+        lua_Alloc AllocFunc = lua_getallocf(L, &UD);
+        (void)AllocFunc; // unused
+        FLuaAllocator* Allocator = static_cast<FLuaAllocator*>(UD);
+        if (!Allocator->IsArena())
+        {
+            lua_close(L);
+        }
+        // Arena: the state and every object live in the arena, which the allocator frees in one go
+        L = nullptr;
+        bArena = false;
+        delete Allocator;
+        MemoryCounters->UsedBytes.store(0, std::memory_order_relaxed);
+        MemoryCounters->GCDebtBytes.store(0, std::memory_order_relaxed);
+
+        // Invalidate outstanding registry handles
+        ++StateGeneration;
+        Tasks.Empty();
+        NativeBindings.Empty();
+        Callbacks.Empty();
+    }
+}
+
+bool ULuaSandbox::SaveBaseline()
+{
+    if (!IsStateAvailable()) return false;
+
+    lua_pushcfunction(L, &SaveBaselineImpl);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Failed to save sandbox baseline: %s"), err ? UTF8_TO_TCHAR(err) : TEXT("<null>"));
+        lua_pop(L, 1);
+        return false;
+    }
+    return true;
+}
+
+bool ULuaSandbox::RestoreBaseline()
+{
+    if (!IsStateAvailable()) return false;
+
+    lua_settop(L, 0);
+    lua_pushcfunction(L, &RestoreBaselineImpl);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Failed to restore sandbox baseline: %s"), err ? UTF8_TO_TCHAR(err) : TEXT("<null>"));
+        lua_pop(L, 1);
+        return false;
+    }
+
+    // Handles resolved before the reset refer to dropped registry slots
+    ++StateGeneration;
+    Tasks.Empty();
+
+    // Budgets belong to the previous user; the next one starts from the project defaults
+    InstructionBudget = INDEX_NONE;
+    FrameInstructionBudget = INDEX_NONE;
+    FrameInstructionsUsed = 0;
+    LastCallBudgetLeft = INDEX_NONE;
+
+    // The baseline has no bindings; bound globals were dropped above and any copies the script kept stop working
+    ClearNativeBindings();
+
+    // Same for the collector. lua_gc reads 0 as "keep the current value", so Lua's defaults are written explicitly
+    if (bGCConfigured)
+    {
+        lua_gc(L, LUA_GCGEN, LuaDefaultGenMinorMul, LuaDefaultGenMajorMul);
+        lua_gc(L, LUA_GCINC, LuaDefaultGCPause, LuaDefaultGCStepMul, LuaDefaultGCStepSizeLog2);
+        GCMode = ELuaGCMode::Incremental;
+        GCParams[0] = GCParams[1] = GCParams[2] = 0;
+        bGCConfigured = false;
+        ApplyGCMode(L);
+    }
+
+    // Release whatever the previous script left behind, including slabs it no longer needs
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    void* UD = nullptr;
+    lua_getallocf(L, &UD);
+    static_cast<FLuaAllocator*>(UD)->Trim();
+    return true;
+}
+
+FLuaRunResult ULuaSandbox::RunString(const FString& Code, int32 TimeoutMs, int32 HookInterval)
+{
+    FLuaRunResult Result;
+    if (!IsStateAvailable(&Result.Error))
+    {
+        Result.bSuccess = false;
+        return Result;
+    }
+
+    // Load chunk with text-only mode (or its cached bytecode)
+    FTCHARToUTF8 CodeUtf8(*Code);
+    int loadStatus = FLuaChunkCache::Get().Load(L, CodeUtf8.Get(), CodeUtf8.Length(), "chunk");
+    if (loadStatus != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        Result.bSuccess = false;
+        Result.Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown load error");
+        lua_pop(L, 1);
+        return Result;
+    }
+
+    return RunLoadedChunk(TimeoutMs, HookInterval);
+}
+
+FLuaRunResult ULuaSandbox::RunScript(const ULuaScript* Script, int32 TimeoutMs, int32 HookInterval)
+{
+    FLuaRunResult Result;
+    if (!IsStateAvailable(&Result.Error))
+    {
+        Result.bSuccess = false;
+        return Result;
+    }
+    if (!Script)
+    {
+        Result.bSuccess = false;
+        Result.Error = TEXT("Script asset is null");
+        return Result;
+    }
+
+    int loadStatus = LUA_ERRSYNTAX;
+    if (Script->HasValidBytecode())
+    {
+        // Trusted path: bytecode was compiled from Source at cook time and its keyed signature verified
+        const TArray<uint8>& Bytecode = Script->GetCompiledBytecode();
+        loadStatus = luaL_loadbufferx(L, reinterpret_cast<const char*>(Bytecode.GetData()), Bytecode.Num(), ULuaScript::ChunkName, "b");
+        if (loadStatus != LUA_OK)
+        {
+            // Incompatible bytecode (e.g. cooked by a different Lua build); fall back to the source text
+            lua_pop(L, 1);
+        }
+    }
+    if (loadStatus != LUA_OK)
+    {
+        FTCHARToUTF8 CodeUtf8(*Script->GetSource());
+        loadStatus = FLuaChunkCache::Get().Load(L, CodeUtf8.Get(), CodeUtf8.Length(), ULuaScript::ChunkName);
+    }
+    if (loadStatus != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        Result.bSuccess = false;
+        Result.Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown load error");
+        lua_pop(L, 1);
+        return Result;
+    }
+
+    return RunLoadedChunk(TimeoutMs, HookInterval);
+}
+
+void ULuaSandbox::SetInstructionBudget(int64 PerCall)
+{
+    InstructionBudget = PerCall;
+}
+
+void ULuaSandbox::SetFrameInstructionBudget(int64 PerFrame)
+{
+    FrameInstructionBudget = PerFrame;
+}
+
+int64 ULuaSandbox::GetRemainingFrameInstructionBudget() const
+{
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    const int64 PerFrame = ResolveInstructionBudget(FrameInstructionBudget, Settings ? Settings->DefaultFrameInstructionBudget : 0);
+    if (PerFrame <= 0)
+    {
+        return INDEX_NONE;
+    }
+    const int64 Used = FrameInstructionsFrame == GFrameCounter ? FrameInstructionsUsed : 0;
+    return FMath::Max<int64>(PerFrame - Used, 0);
+}
+
+int ULuaSandbox::ProtectedCall(int NumArgs, int NumResults, int32 TimeoutMs, int32 HookInterval)
+{
+    return RunHooked(TimeoutMs, HookInterval, nullptr, [this, NumArgs, NumResults]()
+    {
+        return lua_pcall(L, NumArgs, NumResults, 0);
+    });
+}
+
+int ULuaSandbox::RunHooked(int32 TimeoutMs, int32 HookInterval, lua_State* SliceThread, TFunctionRef<int()> Body)
+{
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    const int64 PerCall = ResolveInstructionBudget(InstructionBudget, Settings ? Settings->DefaultInstructionBudget : 0);
+    const int64 PerFrame = ResolveInstructionBudget(FrameInstructionBudget, Settings ? Settings->DefaultFrameInstructionBudget : 0);
+    if (FrameInstructionsFrame != GFrameCounter)
+    {
+        FrameInstructionsFrame = GFrameCounter;
+        FrameInstructionsUsed = 0;
+    }
+
+    // INDEX_NONE: run without an instruction budget
+    int64 Budget = PerCall > 0 ? PerCall : INDEX_NONE;
+    if (PerFrame > 0)
+    {
+        const int64 FrameLeft = FMath::Max<int64>(PerFrame - FrameInstructionsUsed, 0);
+        Budget = Budget == INDEX_NONE ? FrameLeft : FMath::Min(Budget, FrameLeft);
+    }
+
+    int64 Executed = 0;
+    int Status = LUA_OK;
+    ++CallDepth;
+    {
+        FHookScope Hook(L, TimeoutMs, HookInterval, Budget, SliceThread, Executed);
+        Status = Body();
+    }
+    --CallDepth;
+
+    // Nested calls are already included in the outer call's count
+    if (CallDepth == 0 && L)
+    {
+        FrameInstructionsUsed += Executed;
+        MemoryCounters->GCDebtBytes.store((int64)lua_gcdebt(L), std::memory_order_relaxed);
+    }
+    LastCallBudgetLeft = Budget == INDEX_NONE ? INDEX_NONE : FMath::Max<int64>(Budget - Executed, 0);
+    return Status;
+}
+
+FLuaTaskHandle ULuaSandbox::RunStringSliced(const FString& Code, int32 SliceMs, int32 HookInterval)
+{
+    if (!IsStateAvailable())
+    {
+        return FLuaTaskHandle();
+    }
+
+    FTCHARToUTF8 CodeUtf8(*Code);
+    if (FLuaChunkCache::Get().Load(L, CodeUtf8.Get(), CodeUtf8.Length(), "chunk") != LUA_OK)
+    {
+        // Surface the syntax error through the task like a runtime error
+        const char* err = lua_tostring(L, -1);
+        const FString Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown load error");
+        lua_pop(L, 1);
+        return AddFailedTask(Error);
+    }
+    return StartTask(0, SliceMs, HookInterval);
+}
+
+FLuaTaskHandle ULuaSandbox::CallFunctionSliced(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 SliceMs)
+{
+    if (!IsStateAvailable())
+    {
+        return FLuaTaskHandle();
+    }
+
+    lua_getglobal(L, TCHAR_TO_UTF8(*FunctionName));
+    if (!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        return AddFailedTask(FString::Printf(TEXT("'%s' is not a function"), *FunctionName));
+    }
+
+    for (const FLuaValue& Arg : Args)
+    {
+        PushLuaValue(Arg);
+    }
+    return StartTask(Args.Num(), SliceMs, 1000);
+}
+
+FLuaTaskHandle ULuaSandbox::AddFailedTask(const FString& Error)
+{
+    FLuaTaskHandle Handle;
+    Handle.Id = ++LastTaskId;
+    Handle.StateGeneration = StateGeneration;
+
+    FLuaTaskState& Task = Tasks.Add(Handle.Id);
+    Task.Status = ELuaTaskStatus::Failed;
+    Task.Result.Error = Error;
+    return Handle;
+}
+
+FLuaTaskHandle ULuaSandbox::StartTask(int32 NumArgs, int32 SliceMs, int32 HookInterval)
+{
+    FLuaTaskHandle Handle;
+    Handle.Id = ++LastTaskId;
+    Handle.StateGeneration = StateGeneration;
+
+    FLuaTaskState& Task = Tasks.Add(Handle.Id);
+    Task.SliceMs = SliceMs;
+    Task.HookInterval = HookInterval;
+
+    // Move the function and its arguments onto a fresh coroutine kept alive by a registry reference
+    lua_State* Co = lua_newthread(L);
+    lua_insert(L, -(NumArgs + 2));
+    lua_xmove(L, Co, NumArgs + 1);
+    Task.ThreadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    Task.NumArgs = NumArgs;
+    Task.Status = ELuaTaskStatus::Running;
+
+    RunTaskSlice(Handle.Id);
+    return Handle;
+}
+
+void ULuaSandbox::RunTaskSlice(int32 TaskId)
+{
+    // Out of instructions for this frame: try again on the next one
+    if (GetRemainingFrameInstructionBudget() == 0)
+    {
+        return;
+    }
+
+    // The thread stays on the stack while it runs, so cancelling the task from a callback cannot free it
+    FLuaTaskState* Pending = Tasks.Find(TaskId);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, Pending->ThreadRef);
+    lua_State* Co = lua_tothread(L, -1);
+
+    const int NumArgs = Pending->NumArgs;
+    Pending->NumArgs = 0;
+    int NumResults = 0;
+    const int Status = RunHooked(Pending->SliceMs, Pending->HookInterval, Co, [this, Co, NumArgs, &NumResults]()
+    {
+        return lua_resume(Co, L, NumArgs, &NumResults);
+    });
+    lua_pop(L, 1);
+
+    if (Status == LUA_YIELD)
+    {
+        // End of the slice, or the script yielded on its own to wait for the next frame
+        lua_pop(Co, NumResults);
+        return;
+    }
+
+    // Callbacks run during the slice may have started or cancelled tasks
+    FLuaTaskState* Finished = Tasks.Find(TaskId);
+    if (!Finished)
+    {
+        return;
+    }
+    FLuaTaskState& Task = *Finished;
+    if (Status == LUA_OK)
+    {
+        Task.Status = ELuaTaskStatus::Completed;
+        Task.Result.bSuccess = true;
+        if (NumResults > 0)
+        {
+            size_t len = 0;
+            const char* s = lua_tolstring(Co, -1, &len);
+            if (s)
+            {
+                Task.Result.ReturnValue = FString(len, UTF8_TO_TCHAR(s));
+            }
+        }
+    }
+    else
+    {
+        const char* err = lua_tostring(Co, -1);
+        Task.Status = ELuaTaskStatus::Failed;
+        Task.Result.Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown runtime error");
+    }
+    lua_settop(Co, 0);
+    luaL_unref(L, LUA_REGISTRYINDEX, Task.ThreadRef);
+    Task.ThreadRef = LUA_NOREF;
+}
+
+bool ULuaSandbox::IsStateAvailable(FString* OutError) const
+{
+    if (!L)
     {
-        lua_pushnil(L);
-        lua_setfield(L, -2, "dump");
+        if (OutError) *OutError = TEXT("Lua state is not initialized");
+        return false;
     }
-    lua_pop(L, 1);
+    if (AsyncInFlight.load() > 0 && AsyncThreadId.load() != FPlatformTLS::GetCurrentThreadId())
+    {
+        UE_LOG(LogLuaRuntime, Warning, TEXT("%s is busy with async work; call ignored"), *GetName());
+        if (OutError) *OutError = TEXT("Lua sandbox is busy with async work");
+        return false;
+    }
+    return true;
 }
 
-void ULuaSandbox::InstallPrint()
+bool ULuaSandbox::IsTaskHandleCurrent(const FLuaTaskHandle& Handle) const
 {
-    lua_pushcfunction(L, &LuaPrint);
-    lua_setglobal(L, "print");
+    return IsStateAvailable() && Handle.Id != 0 && Handle.StateGeneration == StateGeneration;
 }
 
-void ULuaSandbox::Initialize(int32 MemoryLimitKB)
+ELuaTaskStatus ULuaSandbox::ResumeTask(const FLuaTaskHandle& Handle, FLuaRunResult& OutResult)
 {
-    if (L)
+    FLuaTaskState* Task = IsTaskHandleCurrent(Handle) ? Tasks.Find(Handle.Id) : nullptr;
+    if (!Task)
     {
-        Close();
+        OutResult = FLuaRunResult();
+        OutResult.Error = TEXT("Task handle is not valid for this sandbox");
+        return ELuaTaskStatus::Invalid;
     }
-    L = static_cast<lua_State*>(CreateState(MemoryLimitKB));
-    if (L)
+
+    if (Task->Status == ELuaTaskStatus::Running)
     {
-        OpenSafeLibs();
+        RunTaskSlice(Handle.Id);
+        Task = Tasks.Find(Handle.Id);
+        if (!Task)
+        {
+            OutResult = FLuaRunResult();
+            OutResult.Error = TEXT("Task was cancelled");
+            return ELuaTaskStatus::Invalid;
+        }
     }
-}
 
-void ULuaSandbox::Close()
-{
-    if (L)
+    const ELuaTaskStatus Status = Task->Status;
+    OutResult = Task->Result;
+    if (Status != ELuaTaskStatus::Running)
     {
-        // Free hook state pointer first
-        FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-        delete HS;
-        *reinterpret_cast<FHookState**>(lua_getextraspace(L)) = nullptr;
-
-        void* UD = nullptr;
-        lua_Alloc AllocFunc = lua_getallocf(L, &UD);
-        (void)AllocFunc; // unused
-        lua_close(L);
-        L = nullptr;
-        delete reinterpret_cast<FAllocatorState*>(UD);
+        // The result has been handed out; the handle is spent
+        Tasks.Remove(Handle.Id);
     }
+    return Status;
 }
 
-FLuaRunResult ULuaSandbox::RunString(const FString& Code, int32 TimeoutMs, int32 HookInterval)
+ELuaTaskStatus ULuaSandbox::GetTaskStatus(const FLuaTaskHandle& Handle) const
 {
-    FLuaRunResult Result;
-    if (!L)
-    {
-        Result.bSuccess = false;
-        Result.Error = TEXT("Lua state is not initialized");
-        return Result;
-    }
+    const FLuaTaskState* Task = IsTaskHandleCurrent(Handle) ? Tasks.Find(Handle.Id) : nullptr;
+    return Task ? Task->Status : ELuaTaskStatus::Invalid;
+}
 
-    // Load chunk with text-only mode
-    FTCHARToUTF8 CodeUtf8(*Code);
-    int loadStatus = luaL_loadbufferx(L, CodeUtf8.Get(), CodeUtf8.Length(), "chunk", "t");
-    if (loadStatus != LUA_OK)
+void ULuaSandbox::CancelTask(const FLuaTaskHandle& Handle)
+{
+    const FLuaTaskState* Task = IsTaskHandleCurrent(Handle) ? Tasks.Find(Handle.Id) : nullptr;
+    if (Task)
     {
-        const char* err = lua_tostring(L, -1);
-        Result.bSuccess = false;
-        Result.Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown load error");
-        lua_pop(L, 1);
-        return Result;
+        if (Task->ThreadRef != LUA_NOREF)
+        {
+            luaL_unref(L, LUA_REGISTRYINDEX, Task->ThreadRef);
+        }
+        Tasks.Remove(Handle.Id);
     }
+}
 
-    // Set timeout hook
-    FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-    HS->StartTimeSec = FPlatformTime::Seconds();
-    HS->TimeoutMs = TimeoutMs;
-    lua_sethook(L, &LuaHook, LUA_MASKCOUNT, FMath::Max(1, HookInterval));
+FLuaRunResult ULuaSandbox::RunLoadedChunk(int32 TimeoutMs, int32 HookInterval)
+{
+    FLuaRunResult Result;
 
     // pcall with 0 args, and capture return values
-    int callStatus = lua_pcall(L, 0, LUA_MULTRET, 0);
-
-    // Clear hook
-    lua_sethook(L, nullptr, 0, 0);
+    int callStatus = ProtectedCall(0, LUA_MULTRET, TimeoutMs, HookInterval);
 
     if (callStatus != LUA_OK)
     {
@@ -436,21 +1549,21 @@ FLuaRunResult ULuaSandbox::RunString(const FString& Code, int32 TimeoutMs, int32
 
 void ULuaSandbox::SetGlobalNumber(const FName Name, double Value)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     lua_pushnumber(L, Value);
     lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
 }
 
 void ULuaSandbox::SetGlobalString(const FName Name, const FString& Value)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     PushFString(L, Value);
     lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
 }
 
 bool ULuaSandbox::GetGlobalNumber(const FName Name, double& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
     lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
     if (lua_isnumber(L, -1))
     {
@@ -464,7 +1577,7 @@ bool ULuaSandbox::GetGlobalNumber(const FName Name, double& OutValue) const
 
 bool ULuaSandbox::GetGlobalString(const FName Name, FString& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
     lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
     if (lua_isstring(L, -1))
     {
@@ -480,14 +1593,14 @@ bool ULuaSandbox::GetGlobalString(const FName Name, FString& OutValue) const
 
 void ULuaSandbox::SetGlobalBool(const FName Name, bool Value)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     lua_pushboolean(L, Value ? 1 : 0);
     lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
 }
 
 bool ULuaSandbox::GetGlobalBool(const FName Name, bool& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
     lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
     if (lua_isboolean(L, -1))
     {
@@ -501,14 +1614,14 @@ bool ULuaSandbox::GetGlobalBool(const FName Name, bool& OutValue) const
 
 void ULuaSandbox::SetGlobalDyn(const FName Name, const FLuaDynValue& Value)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     PushLuaDynValue(Value);
     lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
 }
 
 bool ULuaSandbox::GetGlobalDyn(const FName Name, FLuaDynValue& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
     lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
     if (lua_isnil(L, -1))
     {
@@ -520,13 +1633,121 @@ bool ULuaSandbox::GetGlobalDyn(const FName Name, FLuaDynValue& OutValue) const
     return OutValue.Type != ELuaType::Nil;
 }
 
+void ULuaSandbox::SetGlobalFlat(const FName Name, const FLuaFlatValue& Value)
+{
+    if (!IsStateAvailable()) return;
+    PushLuaFlatValue(Value, FLuaFlatValue::RootIndex);
+    lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
+}
+
+bool ULuaSandbox::GetGlobalFlat(const FName Name, FLuaFlatValue& OutValue) const
+{
+    OutValue.Nodes.Reset();
+    if (!IsStateAvailable()) return false;
+    lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
+    ReadLuaFlatValue(L, -1, OutValue);
+    lua_pop(L, 1);
+    return !OutValue.IsNil();
+}
+
+bool ULuaSandbox::CreateGlobalBufferRaw(const FName Name, ELuaBufferType Type, int32 Num, void*& OutData)
+{
+    OutData = nullptr;
+    if (!IsStateAvailable() || Num < 0) return false;
+
+    lua_pushcfunction(L, &NewGlobalBufferImpl);
+    lua_pushinteger(L, ToLuaBufferType(Type));
+    lua_pushinteger(L, Num);
+    lua_pushstring(L, TCHAR_TO_UTF8(*Name.ToString()));
+    if (lua_pcall(L, 3, 1, 0) != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Failed to create Lua buffer '%s': %s"), *Name.ToString(), err ? UTF8_TO_TCHAR(err) : TEXT("<null>"));
+        lua_pop(L, 1);
+        return false;
+    }
+    OutData = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    return true;
+}
+
+void* ULuaSandbox::GetGlobalBufferRaw(const FName Name, ELuaBufferType Type, int32& OutNum) const
+{
+    OutNum = 0;
+    if (!IsStateAvailable()) return nullptr;
+
+    lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
+    int BufferType = 0;
+    size_t Num = 0;
+    void* Data = luaL_tobuffer(L, -1, &BufferType, &Num);
+    lua_pop(L, 1);
+    if (!Data || BufferType != ToLuaBufferType(Type))
+    {
+        return nullptr;
+    }
+    OutNum = (int32)Num;
+    return Data;
+}
+
+template <typename T>
+bool ULuaSandbox::CopyToGlobalBuffer(const FName Name, const TArray<T>& Values)
+{
+    void* Data = nullptr;
+    if (!CreateGlobalBufferRaw(Name, TLuaBufferType<T>::Value, Values.Num(), Data)) return false;
+    FMemory::Memcpy(Data, Values.GetData(), Values.Num() * sizeof(T));
+    return true;
+}
+
+template <typename T>
+bool ULuaSandbox::CopyFromGlobalBuffer(const FName Name, TArray<T>& OutValues) const
+{
+    const TArrayView<T> View = GetGlobalBuffer<T>(Name);
+    if (!View.GetData())
+    {
+        OutValues.Reset();
+        return false;
+    }
+    OutValues.SetNumUninitialized(View.Num());
+    FMemory::Memcpy(OutValues.GetData(), View.GetData(), View.Num() * sizeof(T));
+    return true;
+}
+
+bool ULuaSandbox::SetGlobalFloatBuffer(const FName Name, const TArray<float>& Values)
+{
+    return CopyToGlobalBuffer(Name, Values);
+}
+
+bool ULuaSandbox::SetGlobalDoubleBuffer(const FName Name, const TArray<double>& Values)
+{
+    return CopyToGlobalBuffer(Name, Values);
+}
+
+bool ULuaSandbox::SetGlobalIntBuffer(const FName Name, const TArray<int32>& Values)
+{
+    return CopyToGlobalBuffer(Name, Values);
+}
+
+bool ULuaSandbox::GetGlobalFloatBuffer(const FName Name, TArray<float>& OutValues) const
+{
+    return CopyFromGlobalBuffer(Name, OutValues);
+}
+
+bool ULuaSandbox::GetGlobalDoubleBuffer(const FName Name, TArray<double>& OutValues) const
+{
+    return CopyFromGlobalBuffer(Name, OutValues);
+}
+
+bool ULuaSandbox::GetGlobalIntBuffer(const FName Name, TArray<int32>& OutValues) const
+{
+    return CopyFromGlobalBuffer(Name, OutValues);
+}
+
 FLuaRunResult ULuaSandbox::CallFunction(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 TimeoutMs)
 {
     FLuaRunResult Result;
-    if (!L)
+    if (!IsStateAvailable(&Result.Error))
     {
         Result.bSuccess = false;
-        Result.Error = TEXT("Lua state not initialized");
         return Result;
     }
 
@@ -544,57 +1765,126 @@ FLuaRunResult ULuaSandbox::CallFunction(const FString& FunctionName, const TArra
         PushLuaValue(Arg);
     }
 
-    // Set timeout hook
-    FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-    HS->StartTimeSec = FPlatformTime::Seconds();
-    HS->TimeoutMs = TimeoutMs;
-    lua_sethook(L, &LuaHook, LUA_MASKCOUNT, FMath::Max(1, 1000));
-
-    int callStatus = lua_pcall(L, Args.Num(), 1, 0);
-    
-    // Clear hook
-    lua_sethook(L, nullptr, 0, 0);
+    return CallPushedFunction(Args.Num(), TimeoutMs);
+}
 
-    if (callStatus != LUA_OK)
+FLuaRunResult ULuaSandbox::CallFunctionDyn(const FString& FunctionName, const TArray<FLuaDynValue>& Args, int32 TimeoutMs)
+{
+    FLuaRunResult Result;
+    if (!IsStateAvailable(&Result.Error))
     {
-        const char* err = lua_tostring(L, -1);
         Result.bSuccess = false;
-        Result.Error = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown runtime error");
+        return Result;
+    }
+
+    lua_getglobal(L, TCHAR_TO_UTF8(*FunctionName));
+    if (!lua_isfunction(L, -1))
+    {
         lua_pop(L, 1);
+        Result.bSuccess = false;
+        Result.Error = FString::Printf(TEXT("'%s' is not a function"), *FunctionName);
         return Result;
     }
 
-    if (!lua_isnil(L, -1))
+    for (const FLuaDynValue& Arg : Args)
     {
-        size_t len = 0;
-        const char* s = lua_tolstring(L, -1, &len);
-        if (s)
+        PushLuaDynValue(Arg);
+    }
+
+    return CallPushedFunction(Args.Num(), TimeoutMs);
+}
+
+bool ULuaSandbox::ResolveFunction(const FString& FunctionName, FLuaFunctionRef& OutFunction)
+{
+    OutFunction = FLuaFunctionRef();
+    if (!IsStateAvailable()) return false;
+
+    // Accept "Name" or a dotted path such as "AI.Tick"
+    FString TablePath, Field;
+    if (FunctionName.Split(TEXT("."), &TablePath, &Field, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+    {
+        if (!GetTableByPath(TablePath))
         {
-            Result.ReturnValue = FString(len, UTF8_TO_TCHAR(s));
+            return false;
         }
+        FTCHARToUTF8 Convert(*Field);
+        lua_pushlstring(L, Convert.Get(), Convert.Length());
+        lua_gettable(L, -2);
+        lua_remove(L, -2);
+    }
+    else
+    {
+        lua_getglobal(L, TCHAR_TO_UTF8(*FunctionName));
     }
-    lua_pop(L, 1);
 
-    Result.bSuccess = true;
-    return Result;
+    if (!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+
+    OutFunction.Ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    OutFunction.StateGeneration = StateGeneration;
+    OutFunction.Name = FunctionName;
+    return true;
 }
 
-FLuaRunResult ULuaSandbox::CallFunctionDyn(const FString& FunctionName, const TArray<FLuaDynValue>& Args, int32 TimeoutMs)
+bool ULuaSandbox::LoadFunction(const FString& Code, FLuaFunctionRef& OutFunction, FString& OutError, int32 TimeoutMs)
 {
-    FLuaRunResult Result;
-    if (!L)
+    OutFunction = FLuaFunctionRef();
+    if (!RunStringSingleResult(Code, TimeoutMs, 1000, OutError))
     {
-        Result.bSuccess = false;
-        Result.Error = TEXT("Lua state not initialized");
-        return Result;
+        return false;
     }
 
-    lua_getglobal(L, TCHAR_TO_UTF8(*FunctionName));
     if (!lua_isfunction(L, -1))
     {
+        OutError = TEXT("Code did not return a function");
         lua_pop(L, 1);
-        Result.bSuccess = false;
-        Result.Error = FString::Printf(TEXT("'%s' is not a function"), *FunctionName);
+        return false;
+    }
+
+    OutFunction.Ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    OutFunction.StateGeneration = StateGeneration;
+    OutFunction.Name = TEXT("<loaded>");
+    return true;
+}
+
+bool ULuaSandbox::IsFunctionValid(const FLuaFunctionRef& Function) const
+{
+    return IsStateAvailable() && Function.Ref > 0 && Function.StateGeneration == StateGeneration;
+}
+
+void ULuaSandbox::ReleaseFunction(FLuaFunctionRef& Function)
+{
+    if (IsFunctionValid(Function))
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, Function.Ref);
+    }
+    Function = FLuaFunctionRef();
+}
+
+FLuaRunResult ULuaSandbox::CallFunctionRef(const FLuaFunctionRef& Function, const TArray<FLuaValue>& Args, int32 TimeoutMs)
+{
+    FLuaRunResult Result;
+    if (!PushFunctionRef(Function, Result))
+    {
+        return Result;
+    }
+
+    for (const FLuaValue& Arg : Args)
+    {
+        PushLuaValue(Arg);
+    }
+
+    return CallPushedFunction(Args.Num(), TimeoutMs);
+}
+
+FLuaRunResult ULuaSandbox::CallFunctionRefDyn(const FLuaFunctionRef& Function, const TArray<FLuaDynValue>& Args, int32 TimeoutMs)
+{
+    FLuaRunResult Result;
+    if (!PushFunctionRef(Function, Result))
+    {
         return Result;
     }
 
@@ -603,16 +1893,94 @@ FLuaRunResult ULuaSandbox::CallFunctionDyn(const FString& FunctionName, const TA
         PushLuaDynValue(Arg);
     }
 
-    // Set timeout hook
-    FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-    HS->StartTimeSec = FPlatformTime::Seconds();
-    HS->TimeoutMs = TimeoutMs;
-    lua_sethook(L, &LuaHook, LUA_MASKCOUNT, FMath::Max(1, 1000));
+    return CallPushedFunction(Args.Num(), TimeoutMs);
+}
 
-    int callStatus = lua_pcall(L, Args.Num(), 1, 0);
-    
-    // Clear hook
-    lua_sethook(L, nullptr, 0, 0);
+bool ULuaSandbox::CreateTickEntry(int32 Id, const FString& Name, FLuaTickEntryRef& OutEntry)
+{
+    OutEntry = FLuaTickEntryRef();
+    if (!IsStateAvailable()) return false;
+
+    FTCHARToUTF8 NameUtf8(*Name);
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, (lua_Integer)Id);
+    lua_setfield(L, -2, "id");
+    lua_pushlstring(L, NameUtf8.Get(), NameUtf8.Length());
+    lua_setfield(L, -2, "name");
+
+    OutEntry.Ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    OutEntry.StateGeneration = StateGeneration;
+    return true;
+}
+
+bool ULuaSandbox::IsTickEntryValid(const FLuaTickEntryRef& Entry) const
+{
+    return IsStateAvailable() && Entry.Ref > 0 && Entry.StateGeneration == StateGeneration;
+}
+
+void ULuaSandbox::ReleaseTickEntry(FLuaTickEntryRef& Entry)
+{
+    if (IsTickEntryValid(Entry))
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, Entry.Ref);
+    }
+    Entry = FLuaTickEntryRef();
+}
+
+FLuaRunResult ULuaSandbox::CallTickBatch(const FLuaFunctionRef& Function, float DeltaTime, TConstArrayView<FLuaTickEntryRef> Entries, TConstArrayView<float> EntryDeltaTimes, int32 TimeoutMs)
+{
+    check(Entries.Num() == EntryDeltaTimes.Num());
+
+    FLuaRunResult Result;
+    if (!PushFunctionRef(Function, Result))
+    {
+        return Result;
+    }
+
+    lua_pushnumber(L, (lua_Number)DeltaTime);
+    lua_createtable(L, Entries.Num(), 0);
+    lua_Integer Count = 0;
+    for (int32 i = 0; i < Entries.Num(); ++i)
+    {
+        const FLuaTickEntryRef& Entry = Entries[i];
+        if (Entry.Ref <= 0 || Entry.StateGeneration != StateGeneration)
+        {
+            continue;
+        }
+
+        // Raw set: a metatable the script put on the entry must not run here, outside the protected call
+        lua_rawgeti(L, LUA_REGISTRYINDEX, Entry.Ref);
+        lua_pushliteral(L, "dt");
+        lua_pushnumber(L, (lua_Number)EntryDeltaTimes[i]);
+        lua_rawset(L, -3);
+        lua_rawseti(L, -2, ++Count);
+    }
+
+    return CallPushedFunction(2, TimeoutMs);
+}
+
+bool ULuaSandbox::PushFunctionRef(const FLuaFunctionRef& Function, FLuaRunResult& OutResult)
+{
+    if (!IsStateAvailable(&OutResult.Error))
+    {
+        OutResult.bSuccess = false;
+        return false;
+    }
+    if (!IsFunctionValid(Function))
+    {
+        OutResult.bSuccess = false;
+        OutResult.Error = FString::Printf(TEXT("Function handle '%s' is not valid for this sandbox"), *Function.Name);
+        return false;
+    }
+    lua_rawgeti(L, LUA_REGISTRYINDEX, Function.Ref);
+    return true;
+}
+
+FLuaRunResult ULuaSandbox::CallPushedFunction(int32 NumArgs, int32 TimeoutMs)
+{
+    FLuaRunResult Result;
+
+    int callStatus = ProtectedCall(NumArgs, 1, TimeoutMs, 1000);
 
     if (callStatus != LUA_OK)
     {
@@ -640,7 +2008,7 @@ FLuaRunResult ULuaSandbox::CallFunctionDyn(const FString& FunctionName, const TA
 
 bool ULuaSandbox::HasGlobal(const FName Name) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
     lua_getglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
     bool exists = !lua_isnil(L, -1);
     lua_pop(L, 1);
@@ -649,7 +2017,7 @@ bool ULuaSandbox::HasGlobal(const FName Name) const
 
 void ULuaSandbox::ClearGlobal(const FName Name)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     lua_pushnil(L);
     lua_setglobal(L, TCHAR_TO_UTF8(*Name.ToString()));
 }
@@ -657,7 +2025,7 @@ void ULuaSandbox::ClearGlobal(const FName Name)
 TArray<FString> ULuaSandbox::GetGlobalNames() const
 {
     TArray<FString> Names;
-    if (!L) return Names;
+    if (!IsStateAvailable()) return Names;
 
     lua_pushglobaltable(L);
     lua_pushnil(L);
@@ -677,7 +2045,7 @@ TArray<FString> ULuaSandbox::GetGlobalNames() const
 
 bool ULuaSandbox::SetTableValue(const FString& TablePath, const FString& Key, const FLuaValue& Value)
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
 
     if (!GetTableByPath(TablePath))
     {
@@ -695,7 +2063,7 @@ bool ULuaSandbox::SetTableValue(const FString& TablePath, const FString& Key, co
 
 bool ULuaSandbox::SetTableValueDyn(const FString& TablePath, const FString& Key, const FLuaDynValue& Value)
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
 
     if (!GetTableByPath(TablePath))
     {
@@ -713,7 +2081,7 @@ bool ULuaSandbox::SetTableValueDyn(const FString& TablePath, const FString& Key,
 
 bool ULuaSandbox::GetTableValue(const FString& TablePath, const FString& Key, FLuaValue& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
 
     if (!GetTableByPath(TablePath))
     {
@@ -731,7 +2099,7 @@ bool ULuaSandbox::GetTableValue(const FString& TablePath, const FString& Key, FL
 
 bool ULuaSandbox::GetTableValueDyn(const FString& TablePath, const FString& Key, FLuaDynValue& OutValue) const
 {
-    if (!L) return false;
+    if (!IsStateAvailable()) return false;
 
     if (!GetTableByPath(TablePath))
     {
@@ -747,6 +2115,37 @@ bool ULuaSandbox::GetTableValueDyn(const FString& TablePath, const FString& Key,
     return OutValue.Type != ELuaType::Nil;
 }
 
+bool ULuaSandbox::GetTableValueFlat(const FString& TablePath, const FString& Key, FLuaFlatValue& OutValue) const
+{
+    OutValue.Nodes.Reset();
+    if (!IsStateAvailable()) return false;
+
+    if (!GetTableByPath(TablePath))
+    {
+        return false;
+    }
+
+    FTCHARToUTF8 Convert(*Key);
+    lua_pushlstring(L, Convert.Get(), Convert.Length());
+    lua_gettable(L, -2);
+    ReadLuaFlatValue(L, -1, OutValue);
+    lua_pop(L, 2);
+
+    return !OutValue.IsNil();
+}
+
+ULuaTableRef* ULuaSandbox::GetTableRef(const FString& TablePath)
+{
+    if (!IsStateAvailable()) return nullptr;
+
+    if (!GetTableByPath(TablePath))
+    {
+        return nullptr;
+    }
+
+    return ULuaTableRef::CreateFromTop(this);
+}
+
 FLuaRunResult ULuaSandbox::RunFile(const FString& FilePath, int32 TimeoutMs, int32 HookInterval)
 {
     FLuaRunResult Result;
@@ -764,13 +2163,35 @@ FLuaRunResult ULuaSandbox::RunFile(const FString& FilePath, int32 TimeoutMs, int
 
 bool ULuaSandbox::RunStringDyn(const FString& Code, int32 TimeoutMs, int32 HookInterval, FLuaDynValue& OutValue, FString& OutError)
 {
-    if (!L)
+    if (!RunStringSingleResult(Code, TimeoutMs, HookInterval, OutError))
+    {
+        return false;
+    }
+
+    OutValue = PopLuaDynValue();
+    return true;
+}
+
+bool ULuaSandbox::RunStringFlat(const FString& Code, int32 TimeoutMs, int32 HookInterval, FLuaFlatValue& OutValue, FString& OutError)
+{
+    if (!RunStringSingleResult(Code, TimeoutMs, HookInterval, OutError))
+    {
+        return false;
+    }
+
+    ReadLuaFlatValue(L, -1, OutValue);
+    lua_pop(L, 1);
+    return true;
+}
+
+bool ULuaSandbox::RunStringSingleResult(const FString& Code, int32 TimeoutMs, int32 HookInterval, FString& OutError)
+{
+    if (!IsStateAvailable(&OutError))
     {
-        OutError = TEXT("Lua state is not initialized");
         return false;
     }
     FTCHARToUTF8 CodeUtf8(*Code);
-    int loadStatus = luaL_loadbufferx(L, CodeUtf8.Get(), CodeUtf8.Length(), "chunk", "t");
+    int loadStatus = FLuaChunkCache::Get().Load(L, CodeUtf8.Get(), CodeUtf8.Length(), "chunk");
     if (loadStatus != LUA_OK)
     {
         const char* err = lua_tostring(L, -1);
@@ -779,14 +2200,7 @@ bool ULuaSandbox::RunStringDyn(const FString& Code, int32 TimeoutMs, int32 HookI
         return false;
     }
 
-    FHookState* HS = *reinterpret_cast<FHookState**>(lua_getextraspace(L));
-    HS->StartTimeSec = FPlatformTime::Seconds();
-    HS->TimeoutMs = TimeoutMs;
-    lua_sethook(L, &LuaHook, LUA_MASKCOUNT, FMath::Max(1, HookInterval));
-
-    int callStatus = lua_pcall(L, 0, 1, 0);
-    
-    lua_sethook(L, nullptr, 0, 0);
+    int callStatus = ProtectedCall(0, 1, TimeoutMs, HookInterval);
 
     if (callStatus != LUA_OK)
     {
@@ -796,7 +2210,7 @@ bool ULuaSandbox::RunStringDyn(const FString& Code, int32 TimeoutMs, int32 HookI
         return false;
     }
 
-    OutValue = PopLuaDynValue();
+    // Single result left on the stack for the caller to convert
     return true;
 }
 
@@ -811,61 +2225,344 @@ bool ULuaSandbox::RunFileDyn(const FString& FilePath, int32 TimeoutMs, int32 Hoo
     return RunStringDyn(Content, TimeoutMs, HookInterval, OutValue, OutError);
 }
 
-void ULuaSandbox::RegisterCallback(const FString& CallbackName)
+bool ULuaSandbox::BindNative(const FString& Name, TUniquePtr<FLuaNativeBinding>&& Binding, int (*Thunk)(lua_State*))
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return false;
 
-    auto CallbackFunc = [](lua_State* LuaState) -> int
+    PushBindingClosures(L);
+    if (TUniquePtr<FLuaNativeBinding>* Previous = NativeBindings.Find(Name))
     {
-        ULuaSandbox* Sandbox = nullptr;
-        lua_getallocf(LuaState, reinterpret_cast<void**>(&Sandbox));
-        
-        if (!Sandbox) return 0;
+        // Scripts may still hold the old closure; it stops working rather than outliving its functor
+        lua_pushlightuserdata(L, Previous->Get());
+        lua_rawget(L, -2);
+        DetachBindingClosure(L);
+        lua_pop(L, 1);
+        lua_pushlightuserdata(L, Previous->Get());
+        lua_pushnil(L);
+        lua_rawset(L, -3);
+    }
 
-        lua_getglobal(LuaState, "__callback_name");
-        const char* cbName = lua_tostring(LuaState, -1);
-        lua_pop(LuaState, 1);
+    lua_pushlightuserdata(L, Binding.Get());
+    lua_pushlightuserdata(L, Binding.Get());
+    lua_pushcclosure(L, Thunk, 1);
+    lua_pushvalue(L, -1);
+    lua_setglobal(L, TCHAR_TO_UTF8(*Name));
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+    NativeBindings.Add(Name, MoveTemp(Binding));
+    return true;
+}
 
-        int NumArgs = lua_gettop(LuaState);
-        TArray<FLuaValue> Args;
-        for (int i = 1; i <= NumArgs; i++)
+void ULuaSandbox::ClearNativeBindings()
+{
+    if (L && !NativeBindings.IsEmpty())
+    {
+        PushBindingClosures(L);
+        lua_pushnil(L);
+        while (lua_next(L, -2) != 0)
         {
-            lua_pushvalue(LuaState, i);
-            Args.Add(Sandbox->PopLuaValue());
+            DetachBindingClosure(L);
+            lua_pop(L, 1);
         }
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        lua_setfield(L, LUA_REGISTRYINDEX, BindingsRegistryKey);
+    }
+    NativeBindings.Empty();
+}
+
+void ULuaSandbox::RegisterCallback(const FString& CallbackName)
+{
+    RegisterCallbackWithReturn(CallbackName, FLuaCallbackDelegate());
+}
+
+void ULuaSandbox::RegisterCallbackWithReturn(const FString& CallbackName, FLuaCallbackDelegate Callback)
+{
+    if (!IsStateAvailable()) return;
 
-        if (cbName)
+    // Registering a name again replaces its callback
+    int32 CallbackId = 0;
+    for (const TPair<int32, FLuaCallbackEntry>& Pair : Callbacks)
+    {
+        if (Pair.Value.Name == CallbackName)
         {
-            Sandbox->OnLuaCallback.Broadcast(UTF8_TO_TCHAR(cbName), Args);
+            CallbackId = Pair.Key;
+            break;
         }
+    }
+    if (CallbackId == 0)
+    {
+        CallbackId = ++LastCallbackId;
+    }
+    FLuaCallbackEntry& Entry = Callbacks.FindOrAdd(CallbackId);
+    Entry.Name = CallbackName;
+    Entry.Callback = Callback;
+
+    // The closure carries its sandbox and id, so a call needs no global or string lookup
+    lua_pushlightuserdata(L, this);
+    lua_pushinteger(L, CallbackId);
+    lua_pushcclosure(L, &ULuaSandbox::CallbackTrampoline, 2);
+    lua_setglobal(L, TCHAR_TO_UTF8(*CallbackName));
+}
 
-        return 0;
-    };
+void ULuaSandbox::ClearCallbacks()
+{
+    Callbacks.Empty();
+}
 
-    lua_pushstring(L, TCHAR_TO_UTF8(*CallbackName));
-    lua_setglobal(L, "__callback_name");
-    
-    lua_pushcfunction(L, CallbackFunc);
-    lua_setglobal(L, TCHAR_TO_UTF8(*CallbackName));
+int ULuaSandbox::CallbackTrampoline(lua_State* State)
+{
+    // Lua errors unwind without running destructors, so everything that can raise (luaL_error, and the result push
+    // that may fail with a memory error) happens here, where only POD locals are alive. DispatchCallback reads its
+    // arguments with calls that never allocate and leaves the result in members.
+    ULuaSandbox* Sandbox = static_cast<ULuaSandbox*>(lua_touserdata(State, lua_upvalueindex(1)));
+    if (!Sandbox)
+    {
+        // Defensive: golden images skip closures whose light userdata upvalue they cannot carry
+        return luaL_error(State, "callback is not registered in this sandbox");
+    }
+    if (!IsInGameThread())
+    {
+        return luaL_error(State, "Blueprint callbacks are not available in async execution");
+    }
+
+    const int NumResults = Sandbox->DispatchCallback(State, (int32)lua_tointeger(State, lua_upvalueindex(2)));
+    if (NumResults < 0)
+    {
+        return luaL_error(State, "callback is no longer registered");
+    }
+    if (NumResults > 0)
+    {
+        Sandbox->PushCallbackResult(State);
+    }
+    return NumResults;
+}
+
+void ULuaSandbox::PushCallbackResult(lua_State* State) const
+{
+    if (CallbackResult.bIsNil)
+    {
+        lua_pushnil(State);
+    }
+    else if (bCallbackResultIsString)
+    {
+        lua_pushlstring(State, CallbackResultUtf8.GetData(), CallbackResultUtf8.Num());
+    }
+    else if (CallbackResult.BoolValue)
+    {
+        lua_pushboolean(State, 1);
+    }
+    else
+    {
+        lua_pushnumber(State, CallbackResult.NumberValue);
+    }
+}
+
+int ULuaSandbox::DispatchCallback(lua_State* State, int32 CallbackId)
+{
+    const FLuaCallbackEntry* Entry = Callbacks.Find(CallbackId);
+    if (!Entry)
+    {
+        return -1;
+    }
+    // The handlers may register callbacks and invalidate Entry
+    const FLuaCallbackDelegate Callback = Entry->Callback;
+
+    // Reuse the argument array and its string buffers; a nested callback starts from an empty one
+    TArray<FLuaValue> Args = MoveTemp(CallbackArgs);
+    const int NumArgs = lua_gettop(State);
+    Args.SetNum(NumArgs, EAllowShrinking::No);
+    for (int i = 0; i < NumArgs; ++i)
+    {
+        ReadLuaValue(State, i + 1, Args[i]);
+    }
+
+    if (OnLuaCallback.IsBound())
+    {
+        const FString Name = Entry->Name;
+        OnLuaCallback.Broadcast(Name, Args);
+    }
+
+    const bool bHasResult = Callback.IsBound();
+    if (bHasResult)
+    {
+        // Stored after the handler returns, so callbacks it triggers in turn cannot overwrite it before the push
+        FLuaValue Result = Callback.Execute(Args);
+        bCallbackResultIsString = !Result.StringValue.IsEmpty();
+        CallbackResultUtf8.Reset();
+        if (bCallbackResultIsString)
+        {
+            FTCHARToUTF8 Convert(*Result.StringValue);
+            CallbackResultUtf8.Append(Convert.Get(), Convert.Length());
+        }
+        CallbackResult.bIsNil = Result.bIsNil;
+        CallbackResult.BoolValue = Result.BoolValue;
+        CallbackResult.NumberValue = Result.NumberValue;
+    }
+    CallbackArgs = MoveTemp(Args);
+    return bHasResult ? 1 : 0;
 }
 
 int64 ULuaSandbox::GetMemoryUsage() const
 {
-    if (!L) return 0;
-    
-    FAllocatorState* AllocState = reinterpret_cast<FAllocatorState*>(lua_getextraspace(L));
-    return AllocState ? AllocState->UsedBytes : 0;
+    return MemoryCounters ? MemoryCounters->UsedBytes.load(std::memory_order_relaxed) : 0;
+}
+
+FLuaMemoryStats ULuaSandbox::GetMemoryStats() const
+{
+    FLuaMemoryStats Stats;
+    if (!MemoryCounters) return Stats;
+
+    Stats.UsedBytes = MemoryCounters->UsedBytes.load(std::memory_order_relaxed);
+    Stats.PeakBytes = MemoryCounters->PeakBytes.load(std::memory_order_relaxed);
+    Stats.LimitBytes = MemoryCounters->LimitBytes.load(std::memory_order_relaxed);
+    Stats.NumAllocations = MemoryCounters->NumAllocations.load(std::memory_order_relaxed);
+    Stats.NumFailedAllocations = MemoryCounters->NumFailedAllocations.load(std::memory_order_relaxed);
+    Stats.GCDebtBytes = MemoryCounters->GCDebtBytes.load(std::memory_order_relaxed);
+    Stats.NumSandboxes = 1;
+    return Stats;
+}
+
+FLuaMemoryStats ULuaSandbox::GetTotalMemoryStats()
+{
+    FLuaMemoryStats Total;
+    FScopeLock Lock(&GMemoryCountersLock);
+    for (const TSharedPtr<FLuaMemoryCounters, ESPMode::ThreadSafe>& Counters : GMemoryCounters)
+    {
+        Total.UsedBytes += Counters->UsedBytes.load(std::memory_order_relaxed);
+        Total.PeakBytes += Counters->PeakBytes.load(std::memory_order_relaxed);
+        Total.LimitBytes += Counters->LimitBytes.load(std::memory_order_relaxed);
+        Total.NumAllocations += Counters->NumAllocations.load(std::memory_order_relaxed);
+        Total.NumFailedAllocations += Counters->NumFailedAllocations.load(std::memory_order_relaxed);
+        Total.GCDebtBytes += Counters->GCDebtBytes.load(std::memory_order_relaxed);
+        ++Total.NumSandboxes;
+    }
+    return Total;
 }
 
 void ULuaSandbox::SetMemoryLimit(int32 NewLimitKB)
 {
-    if (!L) return;
+    if (!IsStateAvailable()) return;
     
     AllocLimitBytes = (int64)NewLimitKB * 1024;
-    FAllocatorState* AllocState = reinterpret_cast<FAllocatorState*>(lua_getextraspace(L));
-    if (AllocState)
+    void* UD = nullptr;
+    lua_getallocf(L, &UD);
+    FLuaAllocator* Allocator = static_cast<FLuaAllocator*>(UD);
+    if (Allocator)
+    {
+        Allocator->SetLimitBytes(AllocLimitBytes);
+    }
+}
+
+void ULuaSandbox::SetIncrementalGC(int32 Pause, int32 StepMul, int32 StepSizeLog2)
+{
+    GCMode = ELuaGCMode::Incremental;
+    bGCConfigured = true;
+    // Lua stores percentages divided by 4 in a byte
+    GCParams[0] = FMath::Clamp(Pause, 0, 1023);
+    GCParams[1] = FMath::Clamp(StepMul, 0, 1023);
+    GCParams[2] = FMath::Clamp(StepSizeLog2, 0, 30);
+    if (IsStateAvailable())
+    {
+        ApplyGCMode(L);
+    }
+}
+
+void ULuaSandbox::SetGenerationalGC(int32 MinorMul, int32 MajorMul)
+{
+    GCMode = ELuaGCMode::Generational;
+    bGCConfigured = true;
+    GCParams[0] = FMath::Clamp(MinorMul, 0, 255);
+    GCParams[1] = FMath::Clamp(MajorMul, 0, 1023);
+    GCParams[2] = 0;
+    if (IsStateAvailable())
+    {
+        ApplyGCMode(L);
+    }
+}
+
+bool ULuaSandbox::StepGC(int32 StepKB)
+{
+    if (!IsStateAvailable()) return false;
+
+    const bool bFinishedCycle = lua_gc(L, LUA_GCSTEP, FMath::Max(StepKB, 0)) != 0;
+    MemoryCounters->GCDebtBytes.store((int64)lua_gcdebt(L), std::memory_order_relaxed);
+    return bFinishedCycle;
+}
+
+FLuaAllocatorStats ULuaSandbox::GetAllocatorStats() const
+{
+    FLuaAllocatorStats Stats;
+    if (!IsStateAvailable()) return Stats;
+
+    void* UD = nullptr;
+    lua_getallocf(L, &UD);
+    if (const FLuaAllocator* Allocator = static_cast<const FLuaAllocator*>(UD))
+    {
+        Allocator->GetStats(Stats);
+    }
+    return Stats;
+}
+
+UE::Tasks::TTask<FLuaRunResult> ULuaSandbox::LaunchAsync(const TCHAR* DebugName, TUniqueFunction<FLuaRunResult()>&& Work, FOnLuaAsyncComplete OnComplete)
+{
+    check(IsInGameThread());
+    AsyncInFlight.fetch_add(1);
+
+    // Keeps the sandbox alive until the completion has been delivered
+    TStrongObjectPtr<ULuaSandbox> KeepAlive(this);
+    return AsyncPipe.Launch(DebugName, [this, Work = MoveTemp(Work), OnComplete, KeepAlive = MoveTemp(KeepAlive)]() mutable
+    {
+        AsyncThreadId.store(FPlatformTLS::GetCurrentThreadId());
+        FLuaRunResult Result = Work();
+        AsyncThreadId.store(0);
+        AsyncInFlight.fetch_sub(1);
+
+        AsyncTask(ENamedThreads::GameThread, [Result, OnComplete, KeepAlive = MoveTemp(KeepAlive)]()
+        {
+            OnComplete.ExecuteIfBound(Result);
+        });
+        return Result;
+    });
+}
+
+UE::Tasks::TTask<FLuaRunResult> ULuaSandbox::LaunchRunString(const FString& Code, int32 TimeoutMs, int32 HookInterval)
+{
+    return LaunchAsync(TEXT("LuaRunString"), [this, Code, TimeoutMs, HookInterval]()
+    {
+        return RunString(Code, TimeoutMs, HookInterval);
+    }, FOnLuaAsyncComplete());
+}
+
+UE::Tasks::TTask<FLuaRunResult> ULuaSandbox::LaunchCallFunction(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 TimeoutMs)
+{
+    return LaunchAsync(TEXT("LuaCallFunction"), [this, FunctionName, Args, TimeoutMs]()
+    {
+        return CallFunction(FunctionName, Args, TimeoutMs);
+    }, FOnLuaAsyncComplete());
+}
+
+void ULuaSandbox::RunStringAsync(const FString& Code, FOnLuaAsyncComplete OnComplete, int32 TimeoutMs, int32 HookInterval)
+{
+    LaunchAsync(TEXT("LuaRunString"), [this, Code, TimeoutMs, HookInterval]()
+    {
+        return RunString(Code, TimeoutMs, HookInterval);
+    }, OnComplete);
+}
+
+void ULuaSandbox::CallFunctionAsync(const FString& FunctionName, const TArray<FLuaValue>& Args, FOnLuaAsyncComplete OnComplete, int32 TimeoutMs)
+{
+    LaunchAsync(TEXT("LuaCallFunction"), [this, FunctionName, Args, TimeoutMs]()
+    {
+        return CallFunction(FunctionName, Args, TimeoutMs);
+    }, OnComplete);
+}
+
+void ULuaSandbox::WaitForAsync()
+{
+    if (IsBusy())
     {
-        AllocState->LimitBytes = AllocLimitBytes;
+        AsyncPipe.WaitUntilEmpty();
     }
 }
 
@@ -897,27 +2594,16 @@ bool ULuaSandbox::EvaluateExpressionDyn(const FString& Expression, int32 Timeout
     return RunStringDyn(EvalCode, TimeoutMs, 1000, OutValue, OutError);
 }
 
+bool ULuaSandbox::EvaluateExpressionFlat(const FString& Expression, int32 TimeoutMs, FLuaFlatValue& OutValue, FString& OutError)
+{
+    FString EvalCode = FString::Printf(TEXT("return %s"), *Expression);
+    return RunStringFlat(EvalCode, TimeoutMs, 1000, OutValue, OutError);
+}
+
 void ULuaSandbox::PushLuaValue(const FLuaValue& Value)
 {
     if (!L) return;
-
-    if (Value.bIsNil)
-    {
-        lua_pushnil(L);
-    }
-    else if (!Value.StringValue.IsEmpty())
-    {
-        FTCHARToUTF8 Convert(*Value.StringValue);
-        lua_pushlstring(L, Convert.Get(), Convert.Length());
-    }
-    else if (Value.BoolValue)
-    {
-        lua_pushboolean(L, 1);
-    }
-    else
-    {
-        lua_pushnumber(L, Value.NumberValue);
-    }
+    PushValue(L, Value);
 }
 
 FLuaValue ULuaSandbox::PopLuaValue() const
@@ -925,33 +2611,7 @@ FLuaValue ULuaSandbox::PopLuaValue() const
     FLuaValue Value;
     if (!L) return Value;
 
-    int type = lua_type(L, -1);
-    switch (type)
-    {
-    case LUA_TNIL:
-        Value.bIsNil = true;
-        break;
-    case LUA_TBOOLEAN:
-        Value.BoolValue = lua_toboolean(L, -1) != 0;
-        Value.bIsNil = false;
-        break;
-    case LUA_TNUMBER:
-        Value.NumberValue = lua_tonumber(L, -1);
-        Value.bIsNil = false;
-        break;
-    case LUA_TSTRING:
-        {
-            size_t len = 0;
-            const char* s = lua_tolstring(L, -1, &len);
-            Value.StringValue = FString(len, UTF8_TO_TCHAR(s));
-            Value.bIsNil = false;
-        }
-        break;
-    default:
-        Value.bIsNil = true;
-        break;
-    }
-
+    ReadLuaValue(L, -1, Value);
     lua_pop(L, 1);
     return Value;
 }
@@ -976,6 +2636,9 @@ void ULuaSandbox::PushLuaDynValue(const FLuaDynValue& Value)
         lua_pushlstring(L, Convert.Get(), Convert.Length());
         break;
     }
+    case ELuaType::Vector:
+        lua_pushvector(L, Value.Vector.X, Value.Vector.Y, Value.Vector.Z);
+        break;
     case ELuaType::Array:
     {
         lua_createtable(L, Value.Array.Num(), 0);
@@ -1018,15 +2681,71 @@ void ULuaSandbox::PushLuaDynValue(const FLuaDynValue& Value)
     }
 }
 
-FLuaDynValue ULuaSandbox::PopLuaDynValue() const
+void ULuaSandbox::PushLuaFlatValue(const FLuaFlatValue& Value, int32 NodeIndex)
+{
+    if (!L) return;
+    const FLuaFlatNode* Node = Value.GetNode(NodeIndex);
+    if (!Node)
+    {
+        lua_pushnil(L);
+        return;
+    }
+
+    switch (Node->Type)
+    {
+    case ELuaType::Boolean:
+        lua_pushboolean(L, Node->Boolean ? 1 : 0);
+        break;
+    case ELuaType::Number:
+        lua_pushnumber(L, Node->Number);
+        break;
+    case ELuaType::String:
+    {
+        FTCHARToUTF8 Convert(*Node->String);
+        lua_pushlstring(L, Convert.Get(), Convert.Length());
+        break;
+    }
+    case ELuaType::Vector:
+        lua_pushvector(L, Node->Vector.X, Node->Vector.Y, Node->Vector.Z);
+        break;
+    case ELuaType::Array:
+        lua_createtable(L, Node->NumChildren, 0);
+        for (int32 i = 0; i < Node->NumChildren; ++i)
+        {
+            PushLuaFlatValue(Value, Node->FirstChild + i);
+            lua_seti(L, -2, i + 1);
+        }
+        break;
+    case ELuaType::Table:
+        lua_createtable(L, 0, Node->NumChildren);
+        for (int32 i = 0; i < Node->NumChildren; ++i)
+        {
+            FTCHARToUTF8 KeyUtf8(*Value.Nodes[Node->FirstChild + i].Key);
+            lua_pushlstring(L, KeyUtf8.Get(), KeyUtf8.Length());
+            PushLuaFlatValue(Value, Node->FirstChild + i);
+            lua_settable(L, -3);
+        }
+        break;
+    default:
+        lua_pushnil(L);
+        break;
+    }
+}
+
+FLuaDynValue ULuaSandbox::PopLuaDynValue(int32 MaxDepth) const
 {
     FLuaDynValue V;
     if (!L) return V;
-    ConvertLuaToDynValue(L, -1, V, const_cast<ULuaSandbox*>(this));
+    ConvertLuaToDynValue(L, -1, V, const_cast<ULuaSandbox*>(this), 0, MaxDepth);
     lua_pop(L, 1);
     return V;
 }
 
+FString ULuaSandbox::ReadLuaKey(int Index) const
+{
+    return L ? LuaKeyToString(L, Index) : FString();
+}
+
 bool ULuaSandbox::GetTableByPath(const FString& TablePath) const
 {
     if (!L) return false;
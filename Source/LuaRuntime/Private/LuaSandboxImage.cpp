@@ -0,0 +1,479 @@
+#include "LuaSandboxImage.h"
+#include "LuaRuntime.h"
+#include "LuaChunkCache.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+// Capture walks the source state breadth-first; every table/function/string gets one node.
+// Objects waiting to be expanded are anchored in a Lua table so the walk never re-reads the source graph.
+struct FLuaImageCapture
+{
+    lua_State* L = nullptr;
+    FLuaSandboxImage* Image = nullptr;
+    int Anchor = 0;
+    TMap<const void*, int32> Visited;
+    TMap<void*, int32> UpvalueIds;
+    TArray<int32> Pending;
+
+    int32 AddNode(FLuaSandboxImage::ENodeKind Kind)
+    {
+        const int32 Index = Image->Nodes.AddDefaulted();
+        Image->Nodes[Index].Kind = Kind;
+        return Index;
+    }
+
+    // A C function's upvalues are its private state (a coroutine.wrap thread, a gmatch state); rebuilding it
+    // without one of them would hand the function a nil it never checks for
+    bool CanCaptureCFunction(int Index, int Depth = 0)
+    {
+        if (Depth > 8)
+        {
+            return false;
+        }
+        for (int n = 1; lua_getupvalue(L, Index, n) != nullptr; ++n)
+        {
+            const int Type = lua_type(L, -1);
+            const bool bOk = Type == LUA_TNIL || Type == LUA_TBOOLEAN || Type == LUA_TNUMBER || Type == LUA_TVECTOR
+                || Type == LUA_TSTRING || Type == LUA_TTABLE
+                || (Type == LUA_TFUNCTION && (!lua_iscfunction(L, -1) || CanCaptureCFunction(lua_gettop(L), Depth + 1)));
+            lua_pop(L, 1);
+            if (!bOk)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int32 CaptureValue(int Index)
+    {
+        Index = lua_absindex(L, Index);
+        switch (lua_type(L, Index))
+        {
+        case LUA_TNIL:
+            return INDEX_NONE;
+        case LUA_TBOOLEAN:
+        {
+            const int32 Node = AddNode(FLuaSandboxImage::ENodeKind::Boolean);
+            Image->Nodes[Node].Boolean = lua_toboolean(L, Index) != 0;
+            return Node;
+        }
+        case LUA_TNUMBER:
+        {
+            if (lua_isinteger(L, Index))
+            {
+                const int32 Node = AddNode(FLuaSandboxImage::ENodeKind::Integer);
+                Image->Nodes[Node].Integer = (int64)lua_tointeger(L, Index);
+                return Node;
+            }
+            const int32 Node = AddNode(FLuaSandboxImage::ENodeKind::Number);
+            Image->Nodes[Node].Number = lua_tonumber(L, Index);
+            return Node;
+        }
+        case LUA_TVECTOR:
+        {
+            // Vectors are values (compared by components), so each occurrence gets its own node
+            lua_Number v[3];
+            lua_tovector(L, Index, v);
+            const int32 Node = AddNode(FLuaSandboxImage::ENodeKind::Vector);
+            Image->Nodes[Node].Vector = FVector(v[0], v[1], v[2]);
+            return Node;
+        }
+        case LUA_TSTRING:
+        case LUA_TTABLE:
+        case LUA_TFUNCTION:
+            break;
+        default:
+            // Userdata, threads and light userdata cannot be rebuilt in another state
+            ++Image->NumSkippedValues;
+            return INDEX_NONE;
+        }
+
+        const void* Ptr = lua_topointer(L, Index);
+        if (const int32* Existing = Visited.Find(Ptr))
+        {
+            return *Existing;
+        }
+
+        if (lua_iscfunction(L, Index) && !CanCaptureCFunction(Index))
+        {
+            ++Image->NumSkippedValues;
+            Visited.Add(Ptr, INDEX_NONE);
+            return INDEX_NONE;
+        }
+
+        int32 Node = INDEX_NONE;
+        if (lua_type(L, Index) == LUA_TSTRING)
+        {
+            size_t Len = 0;
+            const char* Str = lua_tolstring(L, Index, &Len);
+            Node = AddNode(FLuaSandboxImage::ENodeKind::String);
+            Image->Nodes[Node].Bytes.Append(reinterpret_cast<const uint8*>(Str), (int32)Len);
+            Visited.Add(Ptr, Node);
+            return Node;
+        }
+
+        if (lua_type(L, Index) == LUA_TTABLE)
+        {
+            Node = AddNode(FLuaSandboxImage::ENodeKind::Table);
+        }
+        else
+        {
+            Node = AddNode(lua_iscfunction(L, Index) ? FLuaSandboxImage::ENodeKind::CFunction : FLuaSandboxImage::ENodeKind::LuaFunction);
+        }
+        Visited.Add(Ptr, Node);
+
+        lua_pushvalue(L, Index);
+        lua_rawseti(L, Anchor, Node + 1);
+        Pending.Add(Node);
+        return Node;
+    }
+
+    void ExpandTable(int32 Node, int Obj)
+    {
+        lua_pushnil(L);
+        while (lua_next(L, Obj) != 0)
+        {
+            const int32 Key = CaptureValue(-2);
+            const int32 Value = CaptureValue(-1);
+            if (Key != INDEX_NONE && Value != INDEX_NONE)
+            {
+                FLuaSandboxImage::FNode& N = Image->Nodes[Node];
+                N.Children.Add(Key);
+                N.Children.Add(Value);
+            }
+            lua_pop(L, 1);
+        }
+
+        if (lua_getmetatable(L, Obj))
+        {
+            const int32 Meta = CaptureValue(-1);
+            Image->Nodes[Node].Metatable = Meta;
+            lua_pop(L, 1);
+        }
+    }
+
+    void ExpandFunction(int32 Node, int Obj)
+    {
+        const bool bLua = Image->Nodes[Node].Kind == FLuaSandboxImage::ENodeKind::LuaFunction;
+
+        lua_Debug Ar;
+        lua_pushvalue(L, Obj);
+        lua_getinfo(L, ">u", &Ar);
+
+        if (bLua)
+        {
+            lua_pushvalue(L, Obj);
+            lua_dump(L, &FLuaChunkCache::WriteBytecode, &Image->Nodes[Node].Bytes, 0);
+            lua_pop(L, 1);
+        }
+        else
+        {
+            Image->Nodes[Node].CFunction = lua_tocfunction(L, Obj);
+        }
+
+        for (int n = 1; n <= (int)Ar.nups; ++n)
+        {
+            lua_getupvalue(L, Obj, n);
+            const int32 Value = CaptureValue(-1);
+            lua_pop(L, 1);
+
+            int32 Id = INDEX_NONE;
+            if (bLua)
+            {
+                void* Cell = lua_upvalueid(L, Obj, n);
+                if (const int32* Existing = UpvalueIds.Find(Cell))
+                {
+                    Id = *Existing;
+                }
+                else
+                {
+                    Id = Image->NumUpvalueIds++;
+                    UpvalueIds.Add(Cell, Id);
+                }
+            }
+
+            FLuaSandboxImage::FNode& N = Image->Nodes[Node];
+            N.Children.Add(Value);
+            N.UpvalueIds.Add(Id);
+        }
+    }
+
+    static int Run(lua_State* L)
+    {
+        FLuaImageCapture* Ctx = static_cast<FLuaImageCapture*>(lua_touserdata(L, 1));
+        lua_settop(L, 0);
+        lua_newtable(L);
+        Ctx->Anchor = lua_gettop(L);
+
+        lua_pushglobaltable(L);
+        Ctx->CaptureValue(-1); // node 0
+        lua_pop(L, 1);
+
+        lua_pushliteral(L, "");
+        if (lua_getmetatable(L, -1))
+        {
+            Ctx->Image->StringMetatable = Ctx->CaptureValue(-1);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+
+        lua_pushvector(L, 0, 0, 0);
+        if (lua_getmetatable(L, -1))
+        {
+            Ctx->Image->VectorMetatable = Ctx->CaptureValue(-1);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+
+        // Buffer metatable lives in the registry; its __index closure holds the buffer library as methods table
+        if (luaL_getmetatable(L, LUA_BUFFERHANDLE) == LUA_TTABLE)
+        {
+            Ctx->Image->BufferMetatable = Ctx->CaptureValue(-1);
+        }
+        lua_pop(L, 1);
+
+        for (int32 p = 0; p < Ctx->Pending.Num(); ++p)
+        {
+            luaL_checkstack(L, 8, "image capture");
+            const int32 Node = Ctx->Pending[p];
+            lua_rawgeti(L, Ctx->Anchor, Node + 1);
+            const int Obj = lua_gettop(L);
+            if (Ctx->Image->Nodes[Node].Kind == FLuaSandboxImage::ENodeKind::Table)
+            {
+                Ctx->ExpandTable(Node, Obj);
+            }
+            else
+            {
+                Ctx->ExpandFunction(Node, Obj);
+            }
+            lua_pop(L, 1);
+        }
+        return 0;
+    }
+};
+
+// Instantiation mirrors capture: phase 1 creates every table/function/string,
+// phase 2 fills table contents, metatables and upvalues (so cycles resolve naturally).
+struct FLuaImageInstantiate
+{
+    const FLuaSandboxImage* Image = nullptr;
+    int Objects = 0;
+    TMap<int32, TPair<int32, int32>> FirstUpvalueOwner;
+
+    void PushNode(lua_State* L, int32 Node) const
+    {
+        if (Node == INDEX_NONE)
+        {
+            lua_pushnil(L);
+            return;
+        }
+        const FLuaSandboxImage::FNode& N = Image->Nodes[Node];
+        switch (N.Kind)
+        {
+        case FLuaSandboxImage::ENodeKind::Boolean:
+            lua_pushboolean(L, N.Boolean ? 1 : 0);
+            break;
+        case FLuaSandboxImage::ENodeKind::Integer:
+            lua_pushinteger(L, (lua_Integer)N.Integer);
+            break;
+        case FLuaSandboxImage::ENodeKind::Number:
+            lua_pushnumber(L, N.Number);
+            break;
+        case FLuaSandboxImage::ENodeKind::Vector:
+            lua_pushvector(L, N.Vector.X, N.Vector.Y, N.Vector.Z);
+            break;
+        default:
+            lua_rawgeti(L, Objects, Node + 1);
+            break;
+        }
+    }
+
+    static int Run(lua_State* L)
+    {
+        FLuaImageInstantiate* Ctx = static_cast<FLuaImageInstantiate*>(lua_touserdata(L, 1));
+        const FLuaSandboxImage* Image = Ctx->Image;
+        lua_settop(L, 0);
+        lua_createtable(L, Image->Nodes.Num(), 0);
+        Ctx->Objects = lua_gettop(L);
+
+        // Phase 1: create objects
+        for (int32 Node = 0; Node < Image->Nodes.Num(); ++Node)
+        {
+            const FLuaSandboxImage::FNode& N = Image->Nodes[Node];
+            switch (N.Kind)
+            {
+            case FLuaSandboxImage::ENodeKind::String:
+                lua_pushlstring(L, reinterpret_cast<const char*>(N.Bytes.GetData()), N.Bytes.Num());
+                break;
+            case FLuaSandboxImage::ENodeKind::Table:
+                if (Node == 0)
+                {
+                    lua_pushglobaltable(L);
+                }
+                else
+                {
+                    lua_createtable(L, 0, N.Children.Num() / 2);
+                }
+                break;
+            case FLuaSandboxImage::ENodeKind::LuaFunction:
+                // Trusted path: bytecode was produced by lua_dump in FLuaImageCapture
+                if (luaL_loadbufferx(L, reinterpret_cast<const char*>(N.Bytes.GetData()), N.Bytes.Num(), "=image", "b") != LUA_OK)
+                {
+                    return lua_error(L);
+                }
+                break;
+            case FLuaSandboxImage::ENodeKind::CFunction:
+                for (int32 n = 0; n < N.Children.Num(); ++n)
+                {
+                    lua_pushnil(L);
+                }
+                lua_pushcclosure(L, N.CFunction, N.Children.Num());
+                break;
+            default:
+                continue;
+            }
+            lua_rawseti(L, Ctx->Objects, Node + 1);
+        }
+
+        // Phase 2: contents, metatables, upvalues
+        for (int32 Node = 0; Node < Image->Nodes.Num(); ++Node)
+        {
+            const FLuaSandboxImage::FNode& N = Image->Nodes[Node];
+            if (N.Kind == FLuaSandboxImage::ENodeKind::Table)
+            {
+                lua_rawgeti(L, Ctx->Objects, Node + 1);
+                for (int32 c = 0; c + 1 < N.Children.Num(); c += 2)
+                {
+                    Ctx->PushNode(L, N.Children[c]);
+                    Ctx->PushNode(L, N.Children[c + 1]);
+                    lua_rawset(L, -3);
+                }
+                if (N.Metatable != INDEX_NONE)
+                {
+                    Ctx->PushNode(L, N.Metatable);
+                    lua_setmetatable(L, -2);
+                }
+                lua_pop(L, 1);
+            }
+            else if (N.Kind == FLuaSandboxImage::ENodeKind::LuaFunction || N.Kind == FLuaSandboxImage::ENodeKind::CFunction)
+            {
+                lua_rawgeti(L, Ctx->Objects, Node + 1);
+                const int Func = lua_gettop(L);
+                for (int32 u = 0; u < N.Children.Num(); ++u)
+                {
+                    const int32 Id = N.UpvalueIds[u];
+                    const TPair<int32, int32>* Owner = Id != INDEX_NONE ? Ctx->FirstUpvalueOwner.Find(Id) : nullptr;
+                    if (Owner)
+                    {
+                        lua_rawgeti(L, Ctx->Objects, Owner->Key + 1);
+                        lua_upvaluejoin(L, Func, u + 1, -1, Owner->Value);
+                        lua_pop(L, 1);
+                    }
+                    else
+                    {
+                        Ctx->PushNode(L, N.Children[u]);
+                        lua_setupvalue(L, Func, u + 1);
+                        if (Id != INDEX_NONE)
+                        {
+                            Ctx->FirstUpvalueOwner.Add(Id, TPair<int32, int32>(Node, u + 1));
+                        }
+                    }
+                }
+                lua_pop(L, 1);
+            }
+        }
+
+        if (Image->StringMetatable != INDEX_NONE)
+        {
+            lua_pushliteral(L, "");
+            Ctx->PushNode(L, Image->StringMetatable);
+            lua_setmetatable(L, -2);
+            lua_pop(L, 1);
+        }
+        if (Image->VectorMetatable != INDEX_NONE)
+        {
+            lua_pushvector(L, 0, 0, 0);
+            Ctx->PushNode(L, Image->VectorMetatable);
+            lua_setmetatable(L, -2);
+            lua_pop(L, 1);
+        }
+        if (Image->BufferMetatable != INDEX_NONE)
+        {
+            Ctx->PushNode(L, Image->BufferMetatable);
+            lua_setfield(L, LUA_REGISTRYINDEX, LUA_BUFFERHANDLE);
+        }
+        return 0;
+    }
+};
+
+TSharedPtr<const FLuaSandboxImage> FLuaSandboxImage::Capture(lua_State* L, FString& OutError)
+{
+    if (!L)
+    {
+        OutError = TEXT("Lua state is not initialized");
+        return nullptr;
+    }
+
+    TSharedPtr<FLuaSandboxImage> Image = MakeShared<FLuaSandboxImage>();
+    FLuaImageCapture Ctx;
+    Ctx.L = L;
+    Ctx.Image = Image.Get();
+
+    lua_pushcfunction(L, &FLuaImageCapture::Run);
+    lua_pushlightuserdata(L, &Ctx);
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        OutError = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown capture error");
+        lua_pop(L, 1);
+        return nullptr;
+    }
+
+    // Anchored objects are garbage now; give the memory back to the source sandbox
+    lua_gc(L, LUA_GCCOLLECT, 0);
+
+    if (Image->NumSkippedValues > 0)
+    {
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Sandbox image skipped %d userdata/thread values and C functions holding them"), Image->NumSkippedValues);
+    }
+    return Image;
+}
+
+bool FLuaSandboxImage::Instantiate(lua_State* L, FString& OutError) const
+{
+    if (!L)
+    {
+        OutError = TEXT("Lua state is not initialized");
+        return false;
+    }
+
+    FLuaImageInstantiate Ctx;
+    Ctx.Image = this;
+
+    lua_pushcfunction(L, &FLuaImageInstantiate::Run);
+    lua_pushlightuserdata(L, &Ctx);
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        OutError = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown instantiation error");
+        lua_pop(L, 1);
+        return false;
+    }
+    return true;
+}
+
+SIZE_T FLuaSandboxImage::GetAllocatedSize() const
+{
+    SIZE_T Size = Nodes.GetAllocatedSize();
+    for (const FNode& N : Nodes)
+    {
+        Size += N.Bytes.GetAllocatedSize() + N.Children.GetAllocatedSize() + N.UpvalueIds.GetAllocatedSize();
+    }
+    return Size;
+}
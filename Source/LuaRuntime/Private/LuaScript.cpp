@@ -1,5 +1,10 @@
 #include "LuaScript.h"
+#include "LuaRuntimeSettings.h"
+#include "LuaChunkCache.h"
 #include "Misc/MessageDialog.h"
+#include "Hash/CityHash.h"
+#include "Misc/SecureHash.h"
+#include "UObject/ObjectSaveContext.h"
 
 // Lua headers for syntax validation
 extern "C" {
@@ -7,6 +12,109 @@ extern "C" {
 #include "lauxlib.h"
 }
 
+// Hash of the UTF-8 source, so the check gives the same result on every platform regardless of TCHAR width
+static uint64 HashSource(const FString& Source)
+{
+    FTCHARToUTF8 Utf8(*Source);
+    return CityHash64(Utf8.Get(), Utf8.Length());
+}
+
+#ifdef LUARUNTIME_BYTECODE_KEY
+static const ANSICHAR GBytecodeKey[] = LUARUNTIME_BYTECODE_KEY;
+
+// Keyed digest over the bytecode and the hash of the source it was built from; an unkeyed checksum could be
+// recomputed by anyone editing the asset
+static void SignBytecode(const TArray<uint8>& Bytecode, uint64 SourceHash, uint8 OutDigest[FSHA1::DigestSize])
+{
+    TArray<uint8> Message(Bytecode);
+    Message.Append(reinterpret_cast<const uint8*>(&SourceHash), sizeof(SourceHash));
+    FSHA1::HMACBuffer(GBytecodeKey, sizeof(GBytecodeKey) - 1, Message.GetData(), Message.Num(), OutDigest);
+}
+#endif
+
+bool ULuaScript::CompileBytecode(bool bStripDebugInfo, FString& OutError)
+{
+    ClearBytecode();
+
+    lua_State* L = luaL_newstate();
+    if (!L)
+    {
+        OutError = TEXT("Failed to create Lua state for compilation");
+        return false;
+    }
+
+    FTCHARToUTF8 CodeUtf8(*Source);
+    int loadStatus = luaL_loadbufferx(L, CodeUtf8.Get(), CodeUtf8.Length(), ChunkName, "t");
+    if (loadStatus != LUA_OK)
+    {
+        const char* err = lua_tostring(L, -1);
+        OutError = err ? UTF8_TO_TCHAR(err) : TEXT("Unknown syntax error");
+        lua_close(L);
+        return false;
+    }
+
+    lua_dump(L, &FLuaChunkCache::WriteBytecode, &CompiledBytecode, bStripDebugInfo ? 1 : 0);
+    lua_close(L);
+
+    CompiledSourceHash = HashSource(Source);
+#ifdef LUARUNTIME_BYTECODE_KEY
+    CompiledBytecodeSignature.SetNumUninitialized(FSHA1::DigestSize);
+    SignBytecode(CompiledBytecode, CompiledSourceHash, CompiledBytecodeSignature.GetData());
+#endif
+    OutError.Empty();
+    return true;
+}
+
+void ULuaScript::ClearBytecode()
+{
+    CompiledBytecode.Empty();
+    CompiledBytecodeSignature.Empty();
+    CompiledSourceHash = 0;
+}
+
+bool ULuaScript::HasValidBytecode() const
+{
+#ifdef LUARUNTIME_BYTECODE_KEY
+    // Source is public and may have been assigned without SetSource
+    if (CompiledBytecode.Num() == 0 || CompiledBytecodeSignature.Num() != FSHA1::DigestSize || HashSource(Source) != CompiledSourceHash)
+    {
+        return false;
+    }
+    uint8 Digest[FSHA1::DigestSize];
+    SignBytecode(CompiledBytecode, CompiledSourceHash, Digest);
+    return FMemory::Memcmp(Digest, CompiledBytecodeSignature.GetData(), FSHA1::DigestSize) == 0;
+#else
+    return false;
+#endif
+}
+
+void ULuaScript::PreSave(FObjectPreSaveContext SaveContext)
+{
+    Super::PreSave(SaveContext);
+
+    // Editor assets keep only Source; cooked assets carry bytecode so shipping builds skip parsing
+    ClearBytecode();
+    const ULuaRuntimeSettings* Settings = GetDefault<ULuaRuntimeSettings>();
+    if (SaveContext.IsCooking() && Settings && Settings->bCookScriptBytecode)
+    {
+#ifdef LUARUNTIME_BYTECODE_KEY
+        FString Error;
+        if (!CompileBytecode(Settings->bStripCookedDebugInfo, Error))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("[LuaScript] %s: not precompiled, syntax error: %s"), *GetPathName(), *Error);
+        }
+#else
+        // Unsigned bytecode would never be trusted at runtime
+        static bool bWarned = false;
+        if (!bWarned)
+        {
+            bWarned = true;
+            UE_LOG(LogTemp, Warning, TEXT("[LuaScript] Cook Script Bytecode is on, but this build has no LUARUNTIME_BYTECODE_KEY; scripts are cooked as source only"));
+        }
+#endif
+    }
+}
+
 #if WITH_EDITOR
 void ULuaScript::ValidateSyntax()
 {
@@ -41,6 +149,7 @@ void ULuaScript::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEv
     // Auto-validate on source edits
     if (PropertyChangedEvent.Property && PropertyChangedEvent.Property->GetFName() == GET_MEMBER_NAME_CHECKED(ULuaScript, Source))
     {
+        ClearBytecode();
         ValidateSyntax();
     }
 }
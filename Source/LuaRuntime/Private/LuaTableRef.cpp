@@ -0,0 +1,282 @@
+#include "LuaTableRef.h"
+#include "LuaSandbox.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+}
+
+namespace {
+
+static void PushKey(lua_State* L, const FString& Key)
+{
+    FTCHARToUTF8 Convert(*Key);
+    lua_pushlstring(L, Convert.Get(), Convert.Length());
+}
+
+}
+
+ULuaTableRef* ULuaTableRef::CreateFromTop(ULuaSandbox* Owner)
+{
+    lua_State* L = Owner ? Owner->L : nullptr;
+    if (!L) return nullptr;
+
+    if (!lua_istable(L, -1))
+    {
+        lua_pop(L, 1);
+        return nullptr;
+    }
+
+    ULuaTableRef* TableRef = NewObject<ULuaTableRef>(Owner);
+    TableRef->Sandbox = Owner;
+    TableRef->Ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    TableRef->StateGeneration = Owner->StateGeneration;
+    return TableRef;
+}
+
+void ULuaTableRef::BeginDestroy()
+{
+    Release();
+    Super::BeginDestroy();
+}
+
+bool ULuaTableRef::IsValid() const
+{
+    const ULuaSandbox* Box = Sandbox.Get();
+    return Box && Box->IsStateAvailable() && Ref > 0 && Box->StateGeneration == StateGeneration;
+}
+
+void ULuaTableRef::Release()
+{
+    if (IsValid())
+    {
+        ULuaSandbox* Box = Sandbox.Get();
+        luaL_unref(Box->L, LUA_REGISTRYINDEX, Ref);
+    }
+    Ref = -2;
+    Sandbox.Reset();
+}
+
+ULuaSandbox* ULuaTableRef::PushTable() const
+{
+    if (!IsValid()) return nullptr;
+
+    ULuaSandbox* Box = Sandbox.Get();
+    lua_rawgeti(Box->L, LUA_REGISTRYINDEX, Ref);
+    return Box;
+}
+
+ULuaSandbox* ULuaTableRef::PushPath(const FString& Path) const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return nullptr;
+    lua_State* L = Box->L;
+
+    TArray<FString> Parts;
+    Path.ParseIntoArray(Parts, TEXT("."), true);
+    for (const FString& Part : Parts)
+    {
+        if (!lua_istable(L, -1))
+        {
+            lua_pop(L, 1);
+            return nullptr;
+        }
+        PushKey(L, Part);
+        lua_rawget(L, -2);
+        lua_remove(L, -2);
+    }
+    return Box;
+}
+
+int32 ULuaTableRef::Length() const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return 0;
+
+    const int32 Len = (int32)lua_rawlen(Box->L, -1);
+    lua_pop(Box->L, 1);
+    return Len;
+}
+
+TArray<FString> ULuaTableRef::GetKeys() const
+{
+    TArray<FString> Keys;
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return Keys;
+    lua_State* L = Box->L;
+
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0)
+    {
+        lua_pop(L, 1); // keep key for next lua_next
+        Keys.Add(Box->ReadLuaKey(-1));
+    }
+    lua_pop(L, 1);
+    return Keys;
+}
+
+bool ULuaTableRef::HasField(const FString& Key) const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    const bool bHas = lua_rawget(Box->L, -2) != LUA_TNIL;
+    lua_pop(Box->L, 2);
+    return bHas;
+}
+
+bool ULuaTableRef::GetField(const FString& Key, FLuaDynValue& OutValue) const
+{
+    OutValue = FLuaDynValue();
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    lua_rawget(Box->L, -2);
+    OutValue = Box->PopLuaDynValue();
+    lua_pop(Box->L, 1);
+    return OutValue.Type != ELuaType::Nil;
+}
+
+bool ULuaTableRef::GetFieldNumber(const FString& Key, double& OutValue) const
+{
+    OutValue = 0.0;
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    const bool bIsNumber = lua_rawget(Box->L, -2) == LUA_TNUMBER;
+    if (bIsNumber)
+    {
+        OutValue = lua_tonumber(Box->L, -1);
+    }
+    lua_pop(Box->L, 2);
+    return bIsNumber;
+}
+
+bool ULuaTableRef::GetFieldString(const FString& Key, FString& OutValue) const
+{
+    OutValue.Reset();
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    const bool bIsString = lua_rawget(Box->L, -2) == LUA_TSTRING;
+    if (bIsString)
+    {
+        size_t len = 0;
+        const char* s = lua_tolstring(Box->L, -1, &len);
+        OutValue = FString(len, UTF8_TO_TCHAR(s));
+    }
+    lua_pop(Box->L, 2);
+    return bIsString;
+}
+
+bool ULuaTableRef::GetFieldBool(const FString& Key, bool& OutValue) const
+{
+    OutValue = false;
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    const bool bIsBool = lua_rawget(Box->L, -2) == LUA_TBOOLEAN;
+    if (bIsBool)
+    {
+        OutValue = lua_toboolean(Box->L, -1) != 0;
+    }
+    lua_pop(Box->L, 2);
+    return bIsBool;
+}
+
+ULuaTableRef* ULuaTableRef::GetFieldTable(const FString& Key) const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return nullptr;
+
+    PushKey(Box->L, Key);
+    lua_rawget(Box->L, -2);
+    lua_remove(Box->L, -2);
+    return CreateFromTop(Box);
+}
+
+bool ULuaTableRef::GetIndex(int32 Index, FLuaDynValue& OutValue) const
+{
+    OutValue = FLuaDynValue();
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    lua_rawgeti(Box->L, -1, Index);
+    OutValue = Box->PopLuaDynValue();
+    lua_pop(Box->L, 1);
+    return OutValue.Type != ELuaType::Nil;
+}
+
+ULuaTableRef* ULuaTableRef::GetIndexTable(int32 Index) const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return nullptr;
+
+    lua_rawgeti(Box->L, -1, Index);
+    lua_remove(Box->L, -2);
+    return CreateFromTop(Box);
+}
+
+bool ULuaTableRef::GetPath(const FString& Path, FLuaDynValue& OutValue) const
+{
+    OutValue = FLuaDynValue();
+    ULuaSandbox* Box = PushPath(Path);
+    if (!Box) return false;
+
+    OutValue = Box->PopLuaDynValue();
+    return OutValue.Type != ELuaType::Nil;
+}
+
+bool ULuaTableRef::GetPathNumber(const FString& Path, double& OutValue) const
+{
+    OutValue = 0.0;
+    ULuaSandbox* Box = PushPath(Path);
+    if (!Box) return false;
+
+    const bool bIsNumber = lua_type(Box->L, -1) == LUA_TNUMBER;
+    if (bIsNumber)
+    {
+        OutValue = lua_tonumber(Box->L, -1);
+    }
+    lua_pop(Box->L, 1);
+    return bIsNumber;
+}
+
+bool ULuaTableRef::SetField(const FString& Key, const FLuaDynValue& Value)
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return false;
+
+    PushKey(Box->L, Key);
+    Box->PushLuaDynValue(Value);
+    lua_rawset(Box->L, -3);
+    lua_pop(Box->L, 1);
+    return true;
+}
+
+void ULuaTableRef::ForEachPair(TFunctionRef<bool(const FString& Key, const FLuaDynValue& Value)> Visitor) const
+{
+    ULuaSandbox* Box = PushTable();
+    if (!Box) return;
+    lua_State* L = Box->L;
+
+    const int Top = lua_gettop(L);
+    lua_pushnil(L);
+    while (lua_next(L, Top) != 0)
+    {
+        const FString Key = Box->ReadLuaKey(-2);
+        // MaxDepth 0: tables are reported by type only, without walking them
+        const FLuaDynValue Value = Box->PopLuaDynValue(0);
+        if (!Visitor(Key, Value))
+        {
+            break;
+        }
+    }
+    lua_settop(L, Top - 1);
+}
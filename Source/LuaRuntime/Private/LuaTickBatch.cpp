@@ -0,0 +1,148 @@
+#include "LuaTickBatch.h"
+#include "LuaComponent.h"
+#include "LuaRuntime.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+
+void FLuaTickBatch::AddMember(ULuaComponent* Component, int32 Id)
+{
+    FMember& Member = Members.AddDefaulted_GetRef();
+    Member.Component = Component;
+    Member.Id = Id;
+    TimeoutMs = FMath::Max(TimeoutMs, Component->TimeoutMs);
+}
+
+void FLuaTickBatch::RemoveMember(int32 Id)
+{
+    const int32 Index = Members.IndexOfByPredicate([Id](const FMember& Member) { return Member.Id == Id; });
+    if (Index == INDEX_NONE)
+    {
+        return;
+    }
+
+    if (ULuaSandbox* Box = Sandbox.Get())
+    {
+        Box->ReleaseTickEntry(Members[Index].Entry);
+    }
+    Members.RemoveAtSwap(Index);
+}
+
+void FLuaTickBatch::ReleaseRefs()
+{
+    if (ULuaSandbox* Box = Sandbox.Get())
+    {
+        for (FMember& Member : Members)
+        {
+            Box->ReleaseTickEntry(Member.Entry);
+        }
+        Box->ReleaseFunction(Function);
+    }
+}
+
+void FLuaTickBatch::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+    // A sandbox with async work queued belongs to its worker thread; members catch up through their dt next time
+    ULuaSandbox* Box = Sandbox.Get();
+    if (!Box || !Box->IsInitialized() || Box->IsBusy())
+    {
+        return;
+    }
+
+    if (!Box->IsFunctionValid(Function) && !Box->ResolveFunction(FunctionName, Function))
+    {
+        ReportError(FString::Printf(TEXT("'%s' is not a function"), *FunctionName));
+        return;
+    }
+
+    TArray<FVector, TInlineAllocator<4>> ViewPoints;
+    if (UWorld* TickWorld = World.Get())
+    {
+        for (FConstPlayerControllerIterator It = TickWorld->GetPlayerControllerIterator(); It; ++It)
+        {
+            const APlayerController* PC = It->Get();
+            if (PC && PC->IsLocalController())
+            {
+                FVector Location;
+                FRotator Rotation;
+                PC->GetPlayerViewPoint(Location, Rotation);
+                ViewPoints.Add(Location);
+            }
+        }
+    }
+
+    DueEntries.Reset();
+    DueDeltaTimes.Reset();
+    for (FMember& Member : Members)
+    {
+        const ULuaComponent* Component = Member.Component.Get();
+        if (!Component)
+        {
+            continue;
+        }
+        Member.PendingDeltaTime += DeltaTime;
+
+        int32 Interval = Component->LuaTickInterval;
+        const AActor* Owner = Component->GetOwner();
+        if (Component->LuaTickNearDistance > 0.0f && Owner && ViewPoints.Num() > 0)
+        {
+            const FVector Location = Owner->GetActorLocation();
+            double MinDistSq = TNumericLimits<double>::Max();
+            for (const FVector& ViewPoint : ViewPoints)
+            {
+                MinDistSq = FMath::Min(MinDistSq, FVector::DistSquared(Location, ViewPoint));
+            }
+            if (MinDistSq > FMath::Square((double)Component->LuaTickNearDistance))
+            {
+                Interval = Component->LuaTickFarInterval;
+            }
+        }
+
+        // Offset by the member id so throttled members spread over frames instead of all running on the same one
+        if (Interval <= 0 || (GFrameCounter + (uint64)Member.Id) % (uint64)Interval != 0)
+        {
+            continue;
+        }
+
+        // Entries are recreated after the sandbox was reset or re-initialized
+        if (!Box->IsTickEntryValid(Member.Entry)
+            && !Box->CreateTickEntry(Member.Id, Owner ? Owner->GetName() : Component->GetName(), Member.Entry))
+        {
+            continue;
+        }
+
+        DueEntries.Add(Member.Entry);
+        DueDeltaTimes.Add(Member.PendingDeltaTime);
+        Member.PendingDeltaTime = 0.0f;
+    }
+
+    if (DueEntries.Num() == 0)
+    {
+        return;
+    }
+
+    TGuardValue<bool> ExecutingGuard(bExecuting, true);
+    const FLuaRunResult Result = Box->CallTickBatch(Function, DeltaTime, DueEntries, DueDeltaTimes, TimeoutMs);
+    if (Result.bSuccess)
+    {
+        bReportedError = false;
+    }
+    else
+    {
+        ReportError(Result.Error);
+    }
+}
+
+FString FLuaTickBatch::DiagnosticMessage()
+{
+    return FString::Printf(TEXT("FLuaTickBatch[%s, %d members]"), *FunctionName, Members.Num());
+}
+
+void FLuaTickBatch::ReportError(const FString& Error)
+{
+    if (!bReportedError)
+    {
+        UE_LOG(LogLuaRuntime, Warning, TEXT("Lua tick '%s' failed: %s"), *FunctionName, *Error);
+        bReportedError = true;
+    }
+}
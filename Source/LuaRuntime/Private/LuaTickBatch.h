@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "LuaSandbox.h"
+
+class ULuaComponent;
+class UWorld;
+
+/**
+ * Batched Lua tick of the components that share a sandbox, tick group and tick function. Registered as a tick
+ * function of the world's persistent level, it makes one FunctionName(dt, actors) call per frame instead of a global
+ * lookup and protected call per actor. Members are throttled by their LuaTickInterval and by distance to the local
+ * players' view points.
+ */
+struct FLuaTickBatch : public FTickFunction
+{
+    struct FMember
+    {
+        TWeakObjectPtr<ULuaComponent> Component;
+        FLuaTickEntryRef Entry;
+        int32 Id = 0;
+        /** Time since the member last ran. */
+        float PendingDeltaTime = 0.0f;
+    };
+
+    TWeakObjectPtr<ULuaSandbox> Sandbox;
+    TWeakObjectPtr<UWorld> World;
+    FString FunctionName;
+    FLuaFunctionRef Function;
+    /** Largest TimeoutMs among the members. */
+    int32 TimeoutMs = 0;
+    TArray<FMember> Members;
+    /** True while the Lua call runs; script callbacks may end play on members meanwhile. */
+    bool bExecuting = false;
+
+    void AddMember(ULuaComponent* Component, int32 Id);
+    void RemoveMember(int32 Id);
+    /** Drop the registry handles held in the sandbox. */
+    void ReleaseRefs();
+
+    //~ Begin FTickFunction
+    virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+    virtual FString DiagnosticMessage() override;
+    //~ End FTickFunction
+
+private:
+    void ReportError(const FString& Error);
+
+    /** Entries and delta times of the members due this frame (reused across frames). */
+    TArray<FLuaTickEntryRef> DueEntries;
+    TArray<float> DueDeltaTimes;
+    /** Set after a failure was logged, so a broken script does not log every frame. */
+    bool bReportedError = false;
+};
@@ -0,0 +1,124 @@
+#include "LuaValue.h"
+#include "UObject/Package.h"
+
+int32 FLuaFlatValue::GetChild(int32 NodeIndex, int32 ChildIndex) const
+{
+    const FLuaFlatNode* Node = GetNode(NodeIndex);
+    if (!Node || ChildIndex < 0 || ChildIndex >= Node->NumChildren)
+    {
+        return INDEX_NONE;
+    }
+    return Node->FirstChild + ChildIndex;
+}
+
+int32 FLuaFlatValue::FindField(int32 NodeIndex, const FString& Key) const
+{
+    const FLuaFlatNode* Node = GetNode(NodeIndex);
+    if (!Node || Node->Type != ELuaType::Table)
+    {
+        return INDEX_NONE;
+    }
+    for (int32 i = 0; i < Node->NumChildren; ++i)
+    {
+        if (Nodes[Node->FirstChild + i].Key == Key)
+        {
+            return Node->FirstChild + i;
+        }
+    }
+    return INDEX_NONE;
+}
+
+FLuaDynValue FLuaFlatValue::ToDynValue(int32 NodeIndex, UObject* Outer) const
+{
+    FLuaDynValue V;
+    const FLuaFlatNode* Node = GetNode(NodeIndex);
+    if (!Node)
+    {
+        return V;
+    }
+
+    if (!Outer)
+    {
+        Outer = GetTransientPackage();
+    }
+
+    V.Type = Node->Type;
+    switch (Node->Type)
+    {
+    case ELuaType::Boolean: V.Boolean = Node->Boolean; break;
+    case ELuaType::Number: V.Number = Node->Number; break;
+    case ELuaType::String: V.String = Node->String; break;
+    case ELuaType::Vector: V.Vector = Node->Vector; break;
+    case ELuaType::Array:
+        V.Array.Reserve(Node->NumChildren);
+        for (int32 i = 0; i < Node->NumChildren; ++i)
+        {
+            ULuaValueObject* Elem = NewObject<ULuaValueObject>(Outer);
+            Elem->Value = ToDynValue(Node->FirstChild + i, Outer);
+            V.Array.Add(Elem);
+        }
+        break;
+    case ELuaType::Table:
+        V.Table.Reserve(Node->NumChildren);
+        for (int32 i = 0; i < Node->NumChildren; ++i)
+        {
+            ULuaValueObject* Child = NewObject<ULuaValueObject>(Outer);
+            Child->Value = ToDynValue(Node->FirstChild + i, Outer);
+            V.Table.Add(Nodes[Node->FirstChild + i].Key, Child);
+        }
+        break;
+    default:
+        break;
+    }
+    return V;
+}
+
+FLuaFlatValue FLuaFlatValue::FromDynValue(const FLuaDynValue& Value)
+{
+    FLuaFlatValue Flat;
+    Flat.Nodes.AddDefaulted();
+    Flat.AppendDynValue(RootIndex, Value);
+    return Flat;
+}
+
+void FLuaFlatValue::AppendDynValue(int32 NodeIndex, const FLuaDynValue& Value)
+{
+    // Nodes may reallocate while children are appended, so only index into it
+    Nodes[NodeIndex].Type = Value.Type;
+    switch (Value.Type)
+    {
+    case ELuaType::Boolean: Nodes[NodeIndex].Boolean = Value.Boolean; break;
+    case ELuaType::Number: Nodes[NodeIndex].Number = Value.Number; break;
+    case ELuaType::String: Nodes[NodeIndex].String = Value.String; break;
+    case ELuaType::Vector: Nodes[NodeIndex].Vector = Value.Vector; break;
+    case ELuaType::Array:
+    {
+        const int32 First = Nodes.AddDefaulted(Value.Array.Num());
+        Nodes[NodeIndex].FirstChild = Value.Array.Num() > 0 ? First : INDEX_NONE;
+        Nodes[NodeIndex].NumChildren = Value.Array.Num();
+        for (int32 i = 0; i < Value.Array.Num(); ++i)
+        {
+            const ULuaValueObject* Elem = Value.Array[i].Get();
+            AppendDynValue(First + i, Elem ? Elem->Value : FLuaDynValue());
+        }
+        break;
+    }
+    case ELuaType::Table:
+    {
+        const int32 First = Nodes.AddDefaulted(Value.Table.Num());
+        Nodes[NodeIndex].FirstChild = Value.Table.Num() > 0 ? First : INDEX_NONE;
+        Nodes[NodeIndex].NumChildren = Value.Table.Num();
+        int32 i = 0;
+        for (const auto& Pair : Value.Table)
+        {
+            Nodes[First + i].Key = Pair.Key;
+            const ULuaValueObject* Child = Pair.Value.Get();
+            AppendDynValue(First + i, Child ? Child->Value : FLuaDynValue());
+            ++i;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -4,6 +4,16 @@
 #include "Serialization/JsonSerializer.h"
 
 // Forward declarations of helpers
+bool ULuaValueLibrary::LuaFlat_AsVector(const FLuaFlatValue& V, int32 Node, FVector& Out, FVector Default)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    if (N && N->Type == ELuaType::Vector)
+    {
+        Out = N->Vector; return true;
+    }
+    Out = Default; return false;
+}
+
 static TSharedPtr<FJsonValue> ToJson(const FLuaDynValue& V);
 static FLuaDynValue FromJson(const TSharedPtr<FJsonValue>& JV);
 static void AppendJson(const FLuaDynValue& V, FString& Out);
@@ -29,6 +39,11 @@ FLuaDynValue ULuaValueLibrary::MakeLuaString(const FString& s)
     FLuaDynValue V; V.Type = ELuaType::String; V.String = s; return V;
 }
 
+FLuaDynValue ULuaValueLibrary::MakeLuaVector(const FVector& v)
+{
+    FLuaDynValue V; V.Type = ELuaType::Vector; V.Vector = v; return V;
+}
+
 FLuaDynValue ULuaValueLibrary::MakeLuaArray(const TArray<FLuaDynValue>& Items)
 {
     FLuaDynValue V; V.Type = ELuaType::Array; V.Array.Reset();
@@ -80,6 +95,15 @@ bool ULuaValueLibrary::LuaValue_AsString(const FLuaDynValue& V, FString& Out, co
     Out = Default; return false;
 }
 
+bool ULuaValueLibrary::LuaValue_AsVector(const FLuaDynValue& V, FVector& Out, FVector Default)
+{
+    if (V.Type == ELuaType::Vector)
+    {
+        Out = V.Vector; return true;
+    }
+    Out = Default; return false;
+}
+
 FString ULuaValueLibrary::LuaValue_ToJson(const FLuaDynValue& V)
 {
     FString S; AppendJson(V, S); return S;
@@ -90,6 +114,67 @@ FLuaDynValue ULuaValueLibrary::LuaValue_FromJson(const FString& Json)
     return ParseJson(Json);
 }
 
+ELuaType ULuaValueLibrary::LuaFlat_GetType(const FLuaFlatValue& V, int32 Node)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    return N ? N->Type : ELuaType::Nil;
+}
+
+int32 ULuaValueLibrary::LuaFlat_Num(const FLuaFlatValue& V, int32 Node)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    return N ? N->NumChildren : 0;
+}
+
+int32 ULuaValueLibrary::LuaFlat_FindPath(const FLuaFlatValue& V, const FString& Path)
+{
+    TArray<FString> Parts;
+    Path.ParseIntoArray(Parts, TEXT("."), true);
+    int32 Node = V.GetNode(FLuaFlatValue::RootIndex) ? FLuaFlatValue::RootIndex : INDEX_NONE;
+    for (const FString& Part : Parts)
+    {
+        if (Node == INDEX_NONE) break;
+        Node = V.FindField(Node, Part);
+    }
+    return Node;
+}
+
+FString ULuaValueLibrary::LuaFlat_GetKey(const FLuaFlatValue& V, int32 Node)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    return N ? N->Key : FString();
+}
+
+bool ULuaValueLibrary::LuaFlat_AsBoolean(const FLuaFlatValue& V, int32 Node, bool& bOut, bool bDefault)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    if (N && N->Type == ELuaType::Boolean)
+    {
+        bOut = N->Boolean; return true;
+    }
+    bOut = bDefault; return false;
+}
+
+bool ULuaValueLibrary::LuaFlat_AsNumber(const FLuaFlatValue& V, int32 Node, double& Out, double Default)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    if (N && N->Type == ELuaType::Number)
+    {
+        Out = N->Number; return true;
+    }
+    Out = Default; return false;
+}
+
+bool ULuaValueLibrary::LuaFlat_AsString(const FLuaFlatValue& V, int32 Node, FString& Out, const FString& Default)
+{
+    const FLuaFlatNode* N = V.GetNode(Node);
+    if (N && N->Type == ELuaType::String)
+    {
+        Out = N->String; return true;
+    }
+    Out = Default; return false;
+}
+
 static TSharedPtr<FJsonValue> ToJson(const FLuaDynValue& V)
 {
     switch (V.Type)
@@ -98,6 +183,15 @@ static TSharedPtr<FJsonValue> ToJson(const FLuaDynValue& V)
     case ELuaType::Boolean: return MakeShared<FJsonValueBoolean>(V.Boolean);
     case ELuaType::Number: return MakeShared<FJsonValueNumber>(V.Number);
     case ELuaType::String: return MakeShared<FJsonValueString>(V.String);
+    case ELuaType::Vector:
+    {
+        // JSON has no vector type; written as an x/y/z object (reads back as a Table)
+        TSharedPtr<FJsonObject> Obj = MakeShared<FJsonObject>();
+        Obj->SetNumberField(TEXT("x"), V.Vector.X);
+        Obj->SetNumberField(TEXT("y"), V.Vector.Y);
+        Obj->SetNumberField(TEXT("z"), V.Vector.Z);
+        return MakeShared<FJsonValueObject>(Obj);
+    }
     case ELuaType::Array:
     {
         TArray<TSharedPtr<FJsonValue>> Arr;
@@ -0,0 +1,140 @@
+#include "LuaWatchdog.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+// Lua headers (vendored under Private/ThirdParty/lua_slim/src)
+extern "C" {
+#include "lua.h"
+}
+
+namespace {
+
+// Longest sleep with nothing armed; deadlines later than the current wake time do not signal the thread
+static constexpr double GIdleWaitSec = 0.1;
+
+}
+
+FLuaWatchdog& FLuaWatchdog::Get()
+{
+    static FLuaWatchdog Instance;
+    return Instance;
+}
+
+FLuaWatchdog::~FLuaWatchdog()
+{
+    Shutdown();
+}
+
+uint64 FLuaWatchdog::Arm(lua_State* L, double DeadlineSec, std::atomic<bool>* OutTimedOut)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (bShutDown || !FPlatformProcess::SupportsMultithreading())
+    {
+        return 0;
+    }
+
+    if (!Thread)
+    {
+        WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+        Thread = FRunnableThread::Create(this, TEXT("LuaWatchdog"), 16 * 1024, TPri_AboveNormal);
+        if (!Thread)
+        {
+            FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+            WakeEvent = nullptr;
+            bShutDown = true;
+            return 0;
+        }
+    }
+
+    FEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.Ticket = ++LastTicket;
+    Entry.L = L;
+    Entry.TimedOut = OutTimedOut;
+    Entry.DeadlineSec = DeadlineSec;
+
+    if (DeadlineSec < WakeTimeSec)
+    {
+        WakeTimeSec = DeadlineSec;
+        WakeEvent->Trigger();
+    }
+    return Entry.Ticket;
+}
+
+void FLuaWatchdog::Disarm(uint64 Ticket)
+{
+    FScopeLock ScopeLock(&Lock);
+    for (int32 Index = 0; Index < Entries.Num(); ++Index)
+    {
+        if (Entries[Index].Ticket == Ticket)
+        {
+            Entries.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+            return;
+        }
+    }
+    // Not found: the deadline already fired
+}
+
+void FLuaWatchdog::Shutdown()
+{
+    FRunnableThread* ThreadToKill = nullptr;
+    {
+        FScopeLock ScopeLock(&Lock);
+        bShutDown = true;
+        ThreadToKill = Thread;
+        Thread = nullptr;
+    }
+    if (ThreadToKill)
+    {
+        ThreadToKill->Kill(true);
+        delete ThreadToKill;
+    }
+
+    FScopeLock ScopeLock(&Lock);
+    if (WakeEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+    }
+    Entries.Reset();
+}
+
+uint32 FLuaWatchdog::Run()
+{
+    while (!bStopping.load())
+    {
+        double WaitSec = GIdleWaitSec;
+        {
+            FScopeLock ScopeLock(&Lock);
+            const double Now = FPlatformTime::Seconds();
+            for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+            {
+                const FEntry& Entry = Entries[Index];
+                if (Entry.DeadlineSec <= Now)
+                {
+                    // The flag goes first: the interrupt hook reads it as soon as the VM notices the interrupt
+                    Entry.TimedOut->store(true);
+                    lua_interrupt(Entry.L);
+                    Entries.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+                }
+                else
+                {
+                    WaitSec = FMath::Min(WaitSec, Entry.DeadlineSec - Now);
+                }
+            }
+            WakeTimeSec = Now + WaitSec;
+        }
+        WakeEvent->Wait(FMath::Max(1, FMath::CeilToInt32(WaitSec * 1000.0)));
+    }
+    return 0;
+}
+
+void FLuaWatchdog::Stop()
+{
+    bStopping.store(true);
+    if (WakeEvent)
+    {
+        WakeEvent->Trigger();
+    }
+}
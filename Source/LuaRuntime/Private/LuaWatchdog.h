@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+struct lua_State;
+class FEvent;
+class FRunnableThread;
+
+/**
+ * Process-wide thread that enforces sandbox timeouts.
+ * A protected call arms its deadline here instead of installing a clock-polling count hook. When the deadline
+ * passes, the watchdog raises the call's timed-out flag and calls lua_interrupt, which makes the VM install the
+ * state's interrupt hook at its next jump or call; that hook sees the flag and raises the timeout error.
+ * Until a deadline actually expires the script runs with no hook at all.
+ */
+class FLuaWatchdog : public FRunnable
+{
+public:
+    static FLuaWatchdog& Get();
+
+    /**
+     * Watch L until DeadlineSec (FPlatformTime::Seconds). OutTimedOut is set before L is interrupted.
+     * Returns a ticket for Disarm, or 0 when no watchdog thread can run (callers then poll the clock themselves).
+     */
+    uint64 Arm(lua_State* L, double DeadlineSec, std::atomic<bool>* OutTimedOut);
+
+    /** Forget a deadline. Once this returns the watchdog no longer touches the state or its flag. */
+    void Disarm(uint64 Ticket);
+
+    /** Stop the thread; later Arm calls return 0. */
+    void Shutdown();
+
+    //~ Begin FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+    //~ End FRunnable
+
+private:
+    FLuaWatchdog() = default;
+    virtual ~FLuaWatchdog() override;
+
+    struct FEntry
+    {
+        uint64 Ticket = 0;
+        lua_State* L = nullptr;
+        std::atomic<bool>* TimedOut = nullptr;
+        double DeadlineSec = 0.0;
+    };
+
+    FCriticalSection Lock;
+    TArray<FEntry> Entries;
+    uint64 LastTicket = 0;
+    // When the thread wakes up next; arming an earlier deadline wakes it sooner
+    double WakeTimeSec = 0.0;
+    FEvent* WakeEvent = nullptr;
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> bStopping{false};
+    bool bShutDown = false;
+};
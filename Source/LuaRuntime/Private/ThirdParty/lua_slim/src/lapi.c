@@ -28,6 +28,7 @@
 #include "ltable.h"
 #include "ltm.h"
 #include "lundump.h"
+#include "lvector.h"
 #include "lvm.h"
 
 
@@ -459,6 +460,24 @@ LUA_API void *lua_touserdata (lua_State *L, int idx) {
 }
 
 
+/*
+** Copies the components of the vector at 'idx' into 'v[0..2]' and
+** returns 1, or returns 0 (leaving 'v' untouched) for any other value.
+*/
+LUA_API int lua_tovector (lua_State *L, int idx, lua_Number *v) {
+  const TValue *o = index2value(L, idx);
+  if (!ttisvector(o))
+    return 0;
+  else {
+    const Vector *vec = vecvalue(o);
+    v[0] = vec->v[0];
+    v[1] = vec->v[1];
+    v[2] = vec->v[2];
+    return 1;
+  }
+}
+
+
 LUA_API lua_State *lua_tothread (lua_State *L, int idx) {
   const TValue *o = index2value(L, idx);
   return (!ttisthread(o)) ? NULL : thvalue(o);
@@ -621,6 +640,18 @@ LUA_API void lua_pushlightuserdata (lua_State *L, void *p) {
 }
 
 
+LUA_API void lua_pushvector (lua_State *L, lua_Number x, lua_Number y,
+                                           lua_Number z) {
+  Vector *v;
+  lua_lock(L);
+  v = luaR_new(L, x, y, z);
+  setvec2s(L, L->top.p, v);
+  api_incr_top(L);
+  luaC_checkGC(L);
+  lua_unlock(L);
+}
+
+
 LUA_API int lua_pushthread (lua_State *L) {
   lua_lock(L);
   setthvalue(L, s2v(L->top.p), L);
@@ -1229,6 +1260,40 @@ LUA_API int lua_gc (lua_State *L, int what, ...) {
 }
 
 
+/*
+** Bytes allocated that the collector has not yet paid for; a GC step
+** runs once this turns positive (negative while the collector is ahead)
+*/
+LUA_API lua_Integer lua_gcdebt (lua_State *L) {
+  return cast(lua_Integer, G(L)->GCdebt);
+}
+
+
+/*
+** Shared string tables: 'lua_sharedstringssize' is the block size
+** 'lua_buildsharedstrings' needs to copy the live short strings of L
+** (collect garbage first to leave dead ones out). The block must not
+** be changed or freed while states created with it are open.
+*/
+LUA_API size_t lua_sharedstringssize (lua_State *L) {
+  size_t size;
+  lua_lock(L);
+  size = luaS_sharedsize(G(L));
+  lua_unlock(L);
+  return size;
+}
+
+
+LUA_API lua_SharedStrings *lua_buildsharedstrings (lua_State *L,
+                                                   void *buff, size_t size) {
+  lua_SharedStrings *s;
+  lua_lock(L);
+  s = luaS_buildshared(G(L), buff, size);
+  lua_unlock(L);
+  return s;
+}
+
+
 
 /*
 ** miscellaneous functions
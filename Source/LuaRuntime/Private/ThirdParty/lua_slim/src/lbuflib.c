@@ -0,0 +1,431 @@
+/*
+** $Id: lbuflib.c $
+** Library for typed numeric buffers
+** See Copyright Notice in lua.h
+*/
+
+#define lbuflib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/*
+** A buffer is a full userdata: this header followed by 'n' elements
+** of the given type, padded so that doubles are aligned.
+*/
+typedef struct Buffer {
+  size_t n;  /* number of elements */
+  int type;  /* LUA_BUFF32, LUA_BUFF64 or LUA_BUFI32 */
+} Buffer;
+
+#define BUFHEADSIZE \
+	((sizeof(Buffer) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+#define bufdata(b)	((void *)((char *)(b) + BUFHEADSIZE))
+
+#if !defined(MAX_SIZET)
+#define MAX_SIZET	((size_t)(~(size_t)0))
+#endif
+
+/* largest buffer; counts must also fit a host 'int' */
+#define MAXBUFELEMS \
+	((MAX_SIZET - BUFHEADSIZE) / sizeof(double) < (size_t)INT_MAX \
+	  ? (MAX_SIZET - BUFHEADSIZE) / sizeof(double) : (size_t)INT_MAX)
+
+
+static const char *const buftypes[] = {"f32", "f64", "i32", NULL};
+
+static const size_t elemsize[] = {
+  sizeof(float), sizeof(double), sizeof(int32_t)
+};
+
+
+/*
+** Expand 'OP(ctype, p)' for the element type of buffer 'b', with 'p'
+** pointing to its first element.
+*/
+#define bufswitch(b,OP) \
+  switch ((b)->type) { \
+    case LUA_BUFF32: { float *p_ = (float *)bufdata(b); OP(float, p_); break; } \
+    case LUA_BUFF64: { double *p_ = (double *)bufdata(b); OP(double, p_); break; } \
+    default: { int32_t *p_ = (int32_t *)bufdata(b); OP(int32_t, p_); break; } \
+  }
+
+
+/* wrap-around integer arithmetic, without signed overflow */
+#define i32add(a,b)	((int32_t)((uint32_t)(a) + (uint32_t)(b)))
+#define i32mul(a,b)	((int32_t)((uint32_t)(a) * (uint32_t)(b)))
+
+
+static Buffer *checkbuffer (lua_State *L, int arg) {
+  return (Buffer *)luaL_checkudata(L, arg, LUA_BUFFERHANDLE);
+}
+
+
+static int32_t checki32 (lua_State *L, int arg) {
+  lua_Integer v = luaL_checkinteger(L, arg);
+  luaL_argcheck(L, INT32_MIN <= v && v <= INT32_MAX, arg,
+                   "value out of 32-bit integer range");
+  return (int32_t)v;
+}
+
+
+static void pushelem (lua_State *L, const Buffer *b, size_t i) {
+  switch (b->type) {
+    case LUA_BUFF32: lua_pushnumber(L, ((float *)bufdata(b))[i]); break;
+    case LUA_BUFF64: lua_pushnumber(L, ((double *)bufdata(b))[i]); break;
+    default: lua_pushinteger(L, ((int32_t *)bufdata(b))[i]); break;
+  }
+}
+
+
+/* store the value at 'arg' into element 'i' */
+static void setelem (lua_State *L, Buffer *b, size_t i, int arg) {
+  switch (b->type) {
+    case LUA_BUFF32:
+      ((float *)bufdata(b))[i] = (float)luaL_checknumber(L, arg);
+      break;
+    case LUA_BUFF64:
+      ((double *)bufdata(b))[i] = (double)luaL_checknumber(L, arg);
+      break;
+    default:
+      ((int32_t *)bufdata(b))[i] = checki32(L, arg);
+      break;
+  }
+}
+
+
+static void createmeta (lua_State *L);
+
+
+LUALIB_API void *luaL_newbuffer (lua_State *L, int type, size_t n) {
+  Buffer *b;
+  lua_assert(0 <= type && type <= LUA_BUFI32 && n <= MAXBUFELEMS);
+  b = (Buffer *)lua_newuserdatauv(L, BUFHEADSIZE + n * elemsize[type], 0);
+  b->n = n;
+  b->type = type;
+  memset(bufdata(b), 0, n * elemsize[type]);
+  createmeta(L);
+  lua_setmetatable(L, -2);
+  return bufdata(b);
+}
+
+
+LUALIB_API void *luaL_tobuffer (lua_State *L, int idx, int *type,
+                                                size_t *n) {
+  Buffer *b = (Buffer *)luaL_testudata(L, idx, LUA_BUFFERHANDLE);
+  if (b == NULL)
+    return NULL;
+  if (type) *type = b->type;
+  if (n) *n = b->n;
+  return bufdata(b);
+}
+
+
+static size_t checkcount (lua_State *L, int arg) {
+  lua_Integer n = luaL_checkinteger(L, arg);
+  luaL_argcheck(L, 0 <= n && (lua_Unsigned)n <= MAXBUFELEMS, arg,
+                   "invalid buffer size");
+  return (size_t)n;
+}
+
+
+static int buf_new (lua_State *L) {
+  int type = luaL_checkoption(L, 1, NULL, buftypes);
+  size_t n = checkcount(L, 2);
+  int hasfill = !lua_isnoneornil(L, 3);
+  Buffer *b;
+  luaL_newbuffer(L, type, n);
+  b = (Buffer *)lua_touserdata(L, -1);
+  if (hasfill && n > 0) {
+    size_t i;
+    setelem(L, b, 0, 3);  /* checks the fill value */
+    for (i = 1; i < n; i++)
+      memcpy((char *)bufdata(b) + i * elemsize[type], bufdata(b),
+             elemsize[type]);
+  }
+  return 1;
+}
+
+
+static int buf_fromtable (lua_State *L) {
+  int type = luaL_checkoption(L, 1, NULL, buftypes);
+  size_t n, i;
+  Buffer *b;
+  luaL_checktype(L, 2, LUA_TTABLE);
+  n = (size_t)luaL_len(L, 2);
+  luaL_argcheck(L, n <= MAXBUFELEMS, 2, "table too long");
+  luaL_newbuffer(L, type, n);
+  b = (Buffer *)lua_touserdata(L, -1);
+  for (i = 0; i < n; i++) {
+    lua_geti(L, 2, (lua_Integer)i + 1);
+    setelem(L, b, i, -1);
+    lua_pop(L, 1);
+  }
+  return 1;
+}
+
+
+static int buf_totable (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i;
+  lua_createtable(L, (int)b->n, 0);
+  for (i = 0; i < b->n; i++) {
+    pushelem(L, b, i);
+    lua_rawseti(L, -2, (lua_Integer)i + 1);
+  }
+  return 1;
+}
+
+
+static int buf_clone (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  void *data = luaL_newbuffer(L, b->type, b->n);
+  memcpy(data, bufdata(b), b->n * elemsize[b->type]);
+  return 1;
+}
+
+
+static int buf_type (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  lua_pushstring(L, buftypes[b->type]);
+  return 1;
+}
+
+
+static int buf_fill (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i;
+  if (b->type == LUA_BUFI32) {
+    int32_t v = checki32(L, 2);
+    int32_t *p = (int32_t *)bufdata(b);
+    for (i = 0; i < b->n; i++) p[i] = v;
+  }
+  else {
+    lua_Number v = luaL_checknumber(L, 2);
+#define FILL(T,p)	for (i = 0; i < b->n; i++) p[i] = (T)v;
+    bufswitch(b, FILL)
+#undef FILL
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+/*
+** b:add(x): adds a number, or element-wise another buffer of the same
+** type and length, in place. Returns 'b'.
+*/
+static int buf_add (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i;
+  if (lua_type(L, 2) == LUA_TNUMBER) {
+    if (b->type == LUA_BUFI32) {
+      int32_t v = checki32(L, 2);
+      int32_t *p = (int32_t *)bufdata(b);
+      for (i = 0; i < b->n; i++) p[i] = i32add(p[i], v);
+    }
+    else {
+      lua_Number v = lua_tonumber(L, 2);
+#define ADDN(T,p)	for (i = 0; i < b->n; i++) p[i] = (T)(p[i] + v);
+      bufswitch(b, ADDN)
+#undef ADDN
+    }
+  }
+  else {
+    Buffer *o = checkbuffer(L, 2);
+    luaL_argcheck(L, o->type == b->type && o->n == b->n, 2,
+                     "buffers must have the same type and length");
+    if (b->type == LUA_BUFI32) {
+      int32_t *p = (int32_t *)bufdata(b);
+      const int32_t *q = (const int32_t *)bufdata(o);
+      for (i = 0; i < b->n; i++) p[i] = i32add(p[i], q[i]);
+    }
+    else {
+#define ADDB(T,p)	{ const T *q = (const T *)bufdata(o); \
+	for (i = 0; i < b->n; i++) p[i] += q[i]; }
+      bufswitch(b, ADDB)
+#undef ADDB
+    }
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+/* b:scale(k): multiplies every element by 'k' in place. Returns 'b'. */
+static int buf_scale (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i;
+  if (b->type == LUA_BUFI32) {
+    int32_t k = checki32(L, 2);
+    int32_t *p = (int32_t *)bufdata(b);
+    for (i = 0; i < b->n; i++) p[i] = i32mul(p[i], k);
+  }
+  else {
+    lua_Number k = luaL_checknumber(L, 2);
+#define SCALE(T,p)	for (i = 0; i < b->n; i++) p[i] = (T)(p[i] * k);
+    bufswitch(b, SCALE)
+#undef SCALE
+  }
+  lua_settop(L, 1);
+  return 1;
+}
+
+
+static int buf_sum (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i;
+  if (b->type == LUA_BUFI32) {
+    const int32_t *p = (const int32_t *)bufdata(b);
+    lua_Integer s = 0;
+    for (i = 0; i < b->n; i++) s += p[i];
+    lua_pushinteger(L, s);
+  }
+  else {
+    lua_Number s = 0;
+#define SUM(T,p)	for (i = 0; i < b->n; i++) s += p[i];
+    bufswitch(b, SUM)
+#undef SUM
+    lua_pushnumber(L, s);
+  }
+  return 1;
+}
+
+
+/* smallest (or, with 'wantmax', largest) element; nil when empty */
+static int minmax (lua_State *L, int wantmax) {
+  Buffer *b = checkbuffer(L, 1);
+  size_t i, best = 0;
+  if (b->n == 0) {
+    luaL_pushfail(L);
+    return 1;
+  }
+#define MINMAX(T,p) \
+  for (i = 1; i < b->n; i++) \
+    if (wantmax ? p[i] > p[best] : p[i] < p[best]) best = i;
+  bufswitch(b, MINMAX)
+#undef MINMAX
+  pushelem(L, b, best);
+  return 1;
+}
+
+
+static int buf_min (lua_State *L) {
+  return minmax(L, 0);
+}
+
+
+static int buf_max (lua_State *L) {
+  return minmax(L, 1);
+}
+
+
+/*
+** b[i] reads element 'i' (1-based; nil when out of range); other keys
+** look up the methods, which are the library functions.
+*/
+static int buf_index (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  if (lua_type(L, 2) == LUA_TNUMBER) {
+    int isint;
+    lua_Integer i = lua_tointegerx(L, 2, &isint);
+    if (isint && 1 <= i && (lua_Unsigned)i <= b->n)
+      pushelem(L, b, (size_t)i - 1);
+    else
+      lua_pushnil(L);
+  }
+  else {
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+  }
+  return 1;
+}
+
+
+static int buf_newindex (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  int isint;
+  lua_Integer i = lua_tointegerx(L, 2, &isint);
+  luaL_argcheck(L, lua_type(L, 2) == LUA_TNUMBER && isint, 2,
+                   "buffer index must be an integer");
+  luaL_argcheck(L, 1 <= i && (lua_Unsigned)i <= b->n, 2,
+                   "index out of range");
+  setelem(L, b, (size_t)i - 1, 3);
+  return 0;
+}
+
+
+static int buf_len (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  lua_pushinteger(L, (lua_Integer)b->n);
+  return 1;
+}
+
+
+static int buf_tostring (lua_State *L) {
+  Buffer *b = checkbuffer(L, 1);
+  lua_pushfstring(L, "buffer(%s, %I)", buftypes[b->type],
+                     (LUAI_UACINT)b->n);
+  return 1;
+}
+
+
+static const luaL_Reg buflib[] = {
+  {"new", buf_new},
+  {"fromtable", buf_fromtable},
+  {"totable", buf_totable},
+  {"clone", buf_clone},
+  {"type", buf_type},
+  {"fill", buf_fill},
+  {"add", buf_add},
+  {"scale", buf_scale},
+  {"sum", buf_sum},
+  {"min", buf_min},
+  {"max", buf_max},
+  {NULL, NULL}
+};
+
+
+/*
+** metamethods
+*/
+static const luaL_Reg metameth[] = {
+  {"__newindex", buf_newindex},
+  {"__len", buf_len},
+  {"__tostring", buf_tostring},
+  {NULL, NULL}
+};
+
+
+/*
+** Push the buffer metatable, creating it on first use (also when a
+** host creates a buffer in a state that never opened the library).
+*/
+static void createmeta (lua_State *L) {
+  if (luaL_newmetatable(L, LUA_BUFFERHANDLE)) {
+    luaL_setfuncs(L, metameth, 0);
+    luaL_newlib(L, buflib);  /* methods */
+    lua_pushcclosure(L, buf_index, 1);
+    lua_setfield(L, -2, "__index");
+  }
+}
+
+
+LUAMOD_API int luaopen_buffer (lua_State *L) {
+  createmeta(L);
+  lua_getfield(L, -1, "__index");
+  lua_getupvalue(L, -1, 1);  /* the library is the methods table */
+  return 1;
+}
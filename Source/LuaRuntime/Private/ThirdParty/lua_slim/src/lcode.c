@@ -1839,6 +1839,45 @@ static int finaltarget (Instruction *code, int i) {
 }
 
 
+#if LUAI_FUSEOPS
+/*
+** Fused opcode for the instruction pair starting with 'op' and
+** followed by 'next', or OP_EXTRAARG (used as "none") if the pair
+** has no fused form.
+*/
+static OpCode fusedop (OpCode op, OpCode next) {
+  switch (op) {
+    case OP_GETFIELD:
+      return (next == OP_GETFIELD) ? OP_GETFIELDF : OP_EXTRAARG;
+    case OP_GETTABUP:
+      return (next == OP_GETFIELD) ? OP_GETTABUPF
+           : (next == OP_CALL) ? OP_GETTABUPC : OP_EXTRAARG;
+    default:
+      return OP_EXTRAARG;
+  }
+}
+
+
+/*
+** Replace the opcode of the first instruction of each fusable pair
+** ('a.b.c', 'math.floor', 'f()' on a global). Pairs do not overlap, so
+** the second instruction of a pair always keeps its plain opcode.
+*/
+static void fuseops (FuncState *fs) {
+  Proto *p = fs->f;
+  int i;
+  for (i = 0; i < fs->pc - 1; i++) {
+    Instruction *pc = &p->code[i];
+    OpCode op = fusedop(GET_OPCODE(*pc), GET_OPCODE(*(pc + 1)));
+    if (op != OP_EXTRAARG) {
+      SET_OPCODE(*pc, op);
+      i++;  /* skip second instruction */
+    }
+  }
+}
+#endif
+
+
 /*
 ** Do a final pass over the code of a function, doing small peephole
 ** optimizations and adjustments.
@@ -1871,4 +1910,7 @@ void luaK_finish (FuncState *fs) {
       default: break;
     }
   }
+#if LUAI_FUSEOPS
+  fuseops(fs);
+#endif
 }
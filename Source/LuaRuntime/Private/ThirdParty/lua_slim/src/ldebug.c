@@ -142,6 +142,30 @@ LUA_API void lua_sethook (lua_State *L, lua_Hook func, int mask, int count) {
 }
 
 
+/*
+** Interrupts: 'lua_interrupt' only sets a flag, so it may be called from
+** another thread while the state runs. The interpreter polls the flag at
+** function entries and jumps (where it already polls 'trap') and, when
+** set, installs the interrupt hook as a count hook firing on the next
+** instruction. A count hook already running has its cycle cut short
+** instead, so 'lua_gethookcount' still tells how many instructions that
+** cycle counted. Code that runs without hooks pays nothing else.
+*/
+LUA_API void lua_setinterrupt (lua_State *L, lua_Hook func) {
+  G(L)->interrupthook = func;
+}
+
+
+LUA_API void lua_interrupt (lua_State *L) {
+  G(L)->interrupt = 1;
+}
+
+
+LUA_API void lua_clearinterrupt (lua_State *L) {
+  G(L)->interrupt = 0;
+}
+
+
 LUA_API lua_Hook lua_gethook (lua_State *L) {
   return L->hook;
 }
@@ -157,6 +181,12 @@ LUA_API int lua_gethookcount (lua_State *L) {
 }
 
 
+/* instructions left before the count hook fires next */
+LUA_API int lua_gethookcountleft (lua_State *L) {
+  return L->hookcount;
+}
+
+
 LUA_API int lua_getstack (lua_State *L, int level, lua_Debug *ar) {
   int status;
   CallInfo *ci;
@@ -438,7 +468,7 @@ static int findsetreg (const Proto *p, int lastpc, int reg) {
     lastpc--;  /* previous instruction was not actually executed */
   for (pc = 0; pc < lastpc; pc++) {
     Instruction i = p->code[pc];
-    OpCode op = GET_OPCODE(i);
+    OpCode op = luaP_unfuse(GET_OPCODE(i));
     int a = GETARG_A(i);
     int change;  /* true if current instruction changed 'reg' */
     switch (op) {
@@ -502,7 +532,7 @@ static const char *basicgetobjname (const Proto *p, int *ppc, int reg,
   *ppc = pc = findsetreg(p, pc, reg);
   if (pc != -1) {  /* could find instruction? */
     Instruction i = p->code[pc];
-    OpCode op = GET_OPCODE(i);
+    OpCode op = luaP_unfuse(GET_OPCODE(i));
     switch (op) {
       case OP_MOVE: {
         int b = GETARG_B(i);  /* move from 'b' to 'a' */
@@ -570,7 +600,7 @@ static const char *getobjname (const Proto *p, int lastpc, int reg,
     return kind;
   else if (lastpc != -1) {  /* could find instruction? */
     Instruction i = p->code[lastpc];
-    OpCode op = GET_OPCODE(i);
+    OpCode op = luaP_unfuse(GET_OPCODE(i));
     switch (op) {
       case OP_GETTABUP: {
         int k = GETARG_C(i);  /* key index */
@@ -612,7 +642,7 @@ static const char *funcnamefromcode (lua_State *L, const Proto *p,
                                      int pc, const char **name) {
   TMS tm = (TMS)0;  /* (initial value avoids warnings) */
   Instruction i = p->code[pc];  /* calling instruction */
-  switch (GET_OPCODE(i)) {
+  switch (luaP_unfuse(GET_OPCODE(i))) {
     case OP_CALL:
     case OP_TAILCALL:
       return getobjname(p, pc, GETARG_A(i), name);  /* get function name */
@@ -921,6 +951,20 @@ int luaG_traceexec (lua_State *L, const Instruction *pc) {
   lu_byte mask = L->hookmask;
   const Proto *p = ci_func(ci)->p;
   int counthook;
+  if (l_unlikely(G(L)->interrupt)) {  /* interrupted? */
+    global_State *g = G(L);
+    g->interrupt = 0;
+    if (g->interrupthook != NULL) {
+      if (mask & LUA_MASKCOUNT) {  /* cut the running count cycle short */
+        L->basehookcount -= L->hookcount - 1;  /* what it really counted */
+        L->hookcount = 1;
+        L->hook = g->interrupthook;
+      }
+      else
+        lua_sethook(L, g->interrupthook, LUA_MASKCOUNT, 1);
+      mask = L->hookmask;
+    }
+  }
   if (!(mask & (LUA_MASKLINE | LUA_MASKCOUNT))) {  /* no hooks? */
     ci->u.l.trap = 0;  /* don't need to stop again */
     return 0;  /* turn off 'trap' */
@@ -930,7 +974,9 @@ int luaG_traceexec (lua_State *L, const Instruction *pc) {
   counthook = (mask & LUA_MASKCOUNT) && (--L->hookcount == 0);
   if (counthook)
     resethookcount(L);  /* reset count */
-  else if (!(mask & LUA_MASKLINE))
+  /* a resumed thread may get a fresh count ('transferhook'), so the
+     yield mark must be cleared even when the count did not expire */
+  else if (!(mask & LUA_MASKLINE) && !(ci->callstatus & CIST_HOOKYIELD))
     return 1;  /* no line hook and count != 0; nothing to be done now */
   if (ci->callstatus & CIST_HOOKYIELD) {  /* hook yielded last time? */
     ci->callstatus &= ~CIST_HOOKYIELD;  /* erase mark */
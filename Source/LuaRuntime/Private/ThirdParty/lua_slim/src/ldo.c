@@ -832,6 +832,17 @@ static int precover (lua_State *L, int status) {
 }
 
 
+/*
+** Hooks follow the running coroutine: a resumed thread takes over the
+** resumer's hook and remaining count, and hands them back when it yields
+** or ends. Count hooks thus meter all threads of a state as one stream.
+*/
+static void transferhook (lua_State *to, lua_State *from) {
+  lua_sethook(to, from->hook, from->hookmask, from->basehookcount);
+  to->hookcount = from->hookcount;
+}
+
+
 LUA_API int lua_resume (lua_State *L, lua_State *from, int nargs,
                                       int *nresults) {
   int status;
@@ -850,6 +861,8 @@ LUA_API int lua_resume (lua_State *L, lua_State *from, int nargs,
   L->nCcalls++;
   luai_userstateresume(L, nargs);
   api_checknelems(L, (L->status == LUA_OK) ? nargs + 1 : nargs);
+  if (from != NULL)
+    transferhook(L, from);
   status = luaD_rawrunprotected(L, resume, &nargs);
    /* continue running after recoverable errors */
   status = precover(L, status);
@@ -862,6 +875,8 @@ LUA_API int lua_resume (lua_State *L, lua_State *from, int nargs,
   }
   *nresults = (status == LUA_YIELD) ? L->ci->u2.nyield
                                     : cast_int(L->top.p - (L->ci->func.p + 1));
+  if (from != NULL)
+    transferhook(from, L);
   lua_unlock(L);
   return status;
 }
@@ -11,6 +11,7 @@
 
 
 #include <stddef.h>
+#include <string.h>
 
 #include "lua.h"
 
@@ -20,6 +21,7 @@
 #include "lgc.h"
 #include "lmem.h"
 #include "lobject.h"
+#include "lopcodes.h"
 #include "lstate.h"
 
 
@@ -260,11 +262,39 @@ Proto *luaF_newproto (lua_State *L) {
   f->linedefined = 0;
   f->lastlinedefined = 0;
   f->source = NULL;
+#if LUAI_INLINECACHE
+  f->icache = NULL;
+#endif
   return f;
 }
 
 
+#if LUAI_INLINECACHE
+/*
+** Allocate the (empty) inline caches of a function once its code is
+** final. Functions without field accesses get none.
+*/
+void luaF_initcache (lua_State *L, Proto *f) {
+  int pc;
+  lua_assert(f->icache == NULL);
+  for (pc = 0; pc < f->sizecode; pc++) {
+    OpCode op = GET_OPCODE(f->code[pc]);
+    if (op == OP_GETFIELD || op == OP_SELF ||
+        op == OP_GETFIELDF || op == OP_GETTABUPF) {
+      f->icache = luaM_newvector(L, f->sizecode, unsigned short);
+      memset(f->icache, 0, f->sizecode * sizeof(unsigned short));
+      return;
+    }
+  }
+}
+#endif
+
+
 void luaF_freeproto (lua_State *L, Proto *f) {
+#if LUAI_INLINECACHE
+  if (f->icache != NULL)
+    luaM_freearray(L, f->icache, f->sizecode);
+#endif
   luaM_freearray(L, f->code, f->sizecode);
   luaM_freearray(L, f->p, f->sizep);
   luaM_freearray(L, f->k, f->sizek);
@@ -242,6 +242,8 @@ void luaC_barrierback_ (lua_State *L, GCObject *o) {
 
 void luaC_fix (lua_State *L, GCObject *o) {
   global_State *g = G(L);
+  if (isshared(o))  /* shared strings are already permanent */
+    return;
   lua_assert(g->allgc == o);  /* object must be 1st in 'allgc' list! */
   set2gray(o);  /* they will be gray forever */
   setage(o, G_OLD);  /* and old forever */
@@ -297,7 +299,8 @@ GCObject *luaC_newobj (lua_State *L, int tt, size_t sz) {
 static void reallymarkobject (global_State *g, GCObject *o) {
   switch (o->tt) {
     case LUA_VSHRSTR:
-    case LUA_VLNGSTR: {
+    case LUA_VLNGSTR:
+    case LUA_VVECTOR: {
       set2black(o);  /* nothing to visit */
       break;
     }
@@ -809,6 +812,9 @@ static void freeobj (lua_State *L, GCObject *o) {
       luaM_freemem(L, ts, sizelstring(ts->u.lnglen));
       break;
     }
+    case LUA_VVECTOR:
+      luaM_freemem(L, o, sizeof(Vector));
+      break;
     default: lua_assert(0);
   }
 }
@@ -74,7 +74,10 @@ void luaX_init (lua_State *L) {
   for (i=0; i<NUM_RESERVED; i++) {
     TString *ts = luaS_new(L, luaX_tokens[i]);
     luaC_fix(L, obj2gco(ts));  /* reserved words are never collected */
-    ts->extra = cast_byte(i+1);  /* reserved word */
+    if (isshared(ts))  /* read-only; marked by the state it came from */
+      lua_assert(ts->extra == i+1);
+    else
+      ts->extra = cast_byte(i+1);  /* reserved word */
   }
 }
 
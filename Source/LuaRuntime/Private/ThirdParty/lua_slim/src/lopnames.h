@@ -96,6 +96,9 @@ static const char *const opnames[] = {
   "VARARG",
   "VARARGPREP",
   "EXTRAARG",
+  "GETFIELDF",
+  "GETTABUPF",
+  "GETTABUPC",
   NULL
 };
 
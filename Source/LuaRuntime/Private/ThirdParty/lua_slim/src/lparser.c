@@ -769,6 +769,9 @@ static void close_func (LexState *ls) {
   luaM_shrinkvector(L, f->p, f->sizep, fs->np, Proto *);
   luaM_shrinkvector(L, f->locvars, f->sizelocvars, fs->ndebugvars, LocVar);
   luaM_shrinkvector(L, f->upvalues, f->sizeupvalues, fs->nups, Upvaldesc);
+#if LUAI_INLINECACHE
+  luaF_initcache(L, f);
+#endif
   ls->fs = fs->prev;
   luaC_checkGC(L);
 }
@@ -358,6 +358,16 @@ LUA_API int lua_resetthread (lua_State *L) {
 
 
 LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
+  return lua_newsharedstate(f, ud, NULL);
+}
+
+
+/*
+** Create a state that finds short strings in 's' (if not NULL) before
+** its own string table. 's' must outlive the state.
+*/
+LUA_API lua_State *lua_newsharedstate (lua_Alloc f, void *ud,
+                                       const lua_SharedStrings *s) {
   int i;
   lua_State *L;
   global_State *g;
@@ -377,12 +387,15 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   g->warnf = NULL;
   g->ud_warn = NULL;
   g->mainthread = L;
-  g->seed = luai_makeseed(L);
+  g->seed = s ? s->seed : luai_makeseed(L);
   g->gcstp = GCSTPGC;  /* no GC while building state */
   g->strt.size = g->strt.nuse = 0;
   g->strt.hash = NULL;
+  g->sharedstr = s;
   setnilvalue(&g->l_registry);
   g->panic = NULL;
+  g->interrupt = 0;
+  g->interrupthook = NULL;
   g->gcstate = GCSpause;
   g->gckind = KGC_INC;
   g->gcstopem = 0;
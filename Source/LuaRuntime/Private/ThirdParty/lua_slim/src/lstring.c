@@ -193,6 +193,13 @@ static TString *internshrstr (lua_State *L, const char *str, size_t l) {
   unsigned int h = luaS_hash(str, l, g->seed);
   TString **list = &tb->hash[lmod(h, tb->size)];
   lua_assert(str != NULL);  /* otherwise 'memcmp'/'memcpy' are undefined */
+  if (g->sharedstr) {  /* shared strings never die and are never local */
+    const struct lua_SharedStrings *s = g->sharedstr;
+    for (ts = s->hash[lmod(h, s->size)]; ts != NULL; ts = ts->u.hnext) {
+      if (l == ts->shrlen && (memcmp(str, getshrstr(ts), l * sizeof(char)) == 0))
+        return ts;
+    }
+  }
   for (ts = *list; ts != NULL; ts = ts->u.hnext) {
     if (l == ts->shrlen && (memcmp(str, getshrstr(ts), l * sizeof(char)) == 0)) {
       /* found! */
@@ -272,3 +279,108 @@ Udata *luaS_newudata (lua_State *L, size_t s, int nuvalue) {
   return u;
 }
 
+
+
+/*
+** {==================================================================
+** Shared string tables
+** A shared table holds copies of the short strings of a bootstrapped
+** state, in one caller-provided block. States created with it search
+** it before their own 'strt', so common names (library functions,
+** metamethods, reserved words) are neither hashed into nor allocated
+** in each state. The copies are never written: they are gray (never
+** white, so the collector never marks them), in no GC list, and carry
+** SHAREDBIT so that 'luaC_fix' leaves them alone.
+** ===================================================================
+*/
+
+typedef union { LUAI_MAXALIGN; } SharedAlign;
+
+#define sharedalign(n) \
+	(((n) + sizeof(SharedAlign) - 1) & ~(sizeof(SharedAlign) - 1))
+
+
+static int sharedbuckets (int nuse) {
+  int size = 1;
+  while (size < nuse)
+    size <<= 1;
+  return size;
+}
+
+
+static size_t sharedheader (int size) {
+  return sharedalign(offsetof(struct lua_SharedStrings, hash) +
+                     cast_sizet(size) * sizeof(TString *));
+}
+
+
+/*
+** Visit the live short strings of 'g' (its own and the shared ones)
+** and either count them (s == NULL) or copy them into 's'.
+*/
+static void sharedvisit (global_State *g, struct lua_SharedStrings *s,
+                         char **buff, int *nuse, size_t *bytes) {
+  const struct lua_SharedStrings *from = g->sharedstr;
+  int pass;
+  for (pass = 0; pass < 2; pass++) {
+    TString *const *vect = (pass == 0) ? g->strt.hash
+                                 : (from ? from->hash : NULL);
+    int n = (pass == 0) ? g->strt.size : (from ? from->size : 0);
+    int i;
+    for (i = 0; i < n; i++) {
+      TString *ts;
+      for (ts = vect[i]; ts != NULL; ts = ts->u.hnext) {
+        size_t sz = sizelstring(ts->shrlen);
+        if (pass == 0 && isdead(g, ts))
+          continue;  /* garbage not swept yet */
+        if (s == NULL) {
+          (*nuse)++;
+          *bytes += sharedalign(sz);
+        }
+        else {
+          TString *copy = cast(TString *, *buff);
+          TString **list = &s->hash[lmod(ts->hash, s->size)];
+          memcpy(copy, ts, sz);  /* header (hash, extra) and contents */
+          copy->next = NULL;
+          copy->marked = cast_byte(bitmask(SHAREDBIT) | G_OLD);
+          copy->u.hnext = *list;
+          *list = copy;
+          s->nuse++;
+          *buff += sharedalign(sz);
+        }
+      }
+    }
+  }
+}
+
+
+size_t luaS_sharedsize (global_State *g) {
+  int nuse = 0;
+  size_t bytes = 0;
+  sharedvisit(g, NULL, NULL, &nuse, &bytes);
+  return sharedheader(sharedbuckets(nuse)) + bytes;
+}
+
+
+struct lua_SharedStrings *luaS_buildshared (global_State *g,
+                                            void *buff, size_t size) {
+  struct lua_SharedStrings *s = cast(struct lua_SharedStrings *, buff);
+  char *next;
+  int nuse = 0;
+  int i;
+  size_t bytes = 0;
+  sharedvisit(g, NULL, NULL, &nuse, &bytes);
+  if (buff == NULL || size < sharedheader(sharedbuckets(nuse)) + bytes)
+    return NULL;
+  s->seed = g->seed;  /* hashes are copied, so users must share the seed */
+  s->size = sharedbuckets(nuse);
+  s->nuse = 0;
+  for (i = 0; i < s->size; i++)
+    s->hash[i] = NULL;
+  next = cast_charp(buff) + sharedheader(s->size);
+  sharedvisit(g, s, &next, NULL, NULL);
+  return s;
+}
+
+/* }================================================================== */
+
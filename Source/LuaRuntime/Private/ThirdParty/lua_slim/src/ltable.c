@@ -36,6 +36,7 @@
 #include "lstate.h"
 #include "lstring.h"
 #include "ltable.h"
+#include "lvector.h"
 #include "lvm.h"
 
 
@@ -178,6 +179,13 @@ static Node *mainpositionTV (const Table *t, const TValue *key) {
       lua_CFunction f = fvalue(key);
       return hashpointer(t, f);
     }
+    case LUA_VVECTOR: {  /* vectors are keyed by value, like numbers */
+      const lua_Number *v = vecvalue(key)->v;
+      unsigned int h = cast_uint(l_hashfloat(v[0]));
+      h = h * 31u + cast_uint(l_hashfloat(v[1]));
+      h = h * 31u + cast_uint(l_hashfloat(v[2]));
+      return hashmod(t, h);
+    }
     default: {
       GCObject *o = gcvalue(key);
       return hashpointer(t, o);
@@ -230,6 +238,8 @@ static int equalkey (const TValue *k1, const Node *n2, int deadok) {
       return fvalue(k1) == fvalueraw(keyval(n2));
     case ctb(LUA_VLNGSTR):
       return luaS_eqlngstr(tsvalue(k1), keystrval(n2));
+    case ctb(LUA_VVECTOR):
+      return luaR_equal(vecvalue(k1), gco2vec(gcvalueraw(keyval(n2))));
     default:
       return gcvalue(k1) == gcvalueraw(keyval(n2));
   }
@@ -678,6 +688,12 @@ static void luaH_newkey (lua_State *L, Table *t, const TValue *key,
     else if (l_unlikely(luai_numisnan(f)))
       luaG_runerror(L, "table index is NaN");
   }
+  else if (ttisvector(key)) {  /* compared by value, so NaN never matches */
+    const lua_Number *v = vecvalue(key)->v;
+    if (l_unlikely(luai_numisnan(v[0]) || luai_numisnan(v[1]) ||
+                   luai_numisnan(v[2])))
+      luaG_runerror(L, "table index is NaN");
+  }
   if (ttisnil(value))
     return;  /* do not insert nil values */
   mp = mainpositionTV(t, key);
@@ -71,8 +71,9 @@ typedef struct lua_State lua_State;
 #define LUA_TFUNCTION		6
 #define LUA_TUSERDATA		7
 #define LUA_TTHREAD		8
+#define LUA_TVECTOR		9
 
-#define LUA_NUMTYPES		9
+#define LUA_NUMTYPES		10
 
 
 
@@ -157,10 +158,22 @@ typedef void (*lua_Hook) (lua_State *L, lua_Debug *ar);
 extern const char lua_ident[];
 
 
+/*
+** Immutable table of short strings shared by several states
+*/
+typedef struct lua_SharedStrings lua_SharedStrings;
+
+LUA_API size_t (lua_sharedstringssize) (lua_State *L);
+LUA_API lua_SharedStrings *(lua_buildsharedstrings) (lua_State *L,
+                                                     void *buff, size_t size);
+
+
 /*
 ** state manipulation
 */
 LUA_API lua_State *(lua_newstate) (lua_Alloc f, void *ud);
+LUA_API lua_State *(lua_newsharedstate) (lua_Alloc f, void *ud,
+                                         const lua_SharedStrings *s);
 LUA_API void       (lua_close) (lua_State *L);
 LUA_API lua_State *(lua_newthread) (lua_State *L);
 LUA_API int        (lua_closethread) (lua_State *L, lua_State *from);
@@ -205,6 +218,7 @@ LUA_API const char     *(lua_tolstring) (lua_State *L, int idx, size_t *len);
 LUA_API lua_Unsigned    (lua_rawlen) (lua_State *L, int idx);
 LUA_API lua_CFunction   (lua_tocfunction) (lua_State *L, int idx);
 LUA_API void	       *(lua_touserdata) (lua_State *L, int idx);
+LUA_API int             (lua_tovector) (lua_State *L, int idx, lua_Number *v);
 LUA_API lua_State      *(lua_tothread) (lua_State *L, int idx);
 LUA_API const void     *(lua_topointer) (lua_State *L, int idx);
 
@@ -252,6 +266,8 @@ LUA_API const char *(lua_pushfstring) (lua_State *L, const char *fmt, ...);
 LUA_API void  (lua_pushcclosure) (lua_State *L, lua_CFunction fn, int n);
 LUA_API void  (lua_pushboolean) (lua_State *L, int b);
 LUA_API void  (lua_pushlightuserdata) (lua_State *L, void *p);
+LUA_API void  (lua_pushvector) (lua_State *L, lua_Number x, lua_Number y,
+                                              lua_Number z);
 LUA_API int   (lua_pushthread) (lua_State *L);
 
 
@@ -340,6 +356,7 @@ LUA_API void (lua_warning)  (lua_State *L, const char *msg, int tocont);
 #define LUA_GCINC		11
 
 LUA_API int (lua_gc) (lua_State *L, int what, ...);
+LUA_API lua_Integer (lua_gcdebt) (lua_State *L);
 
 
 /*
@@ -386,6 +403,7 @@ LUA_API void (lua_closeslot) (lua_State *L, int idx);
 #define lua_islightuserdata(L,n)	(lua_type(L, (n)) == LUA_TLIGHTUSERDATA)
 #define lua_isnil(L,n)		(lua_type(L, (n)) == LUA_TNIL)
 #define lua_isboolean(L,n)	(lua_type(L, (n)) == LUA_TBOOLEAN)
+#define lua_isvector(L,n)	(lua_type(L, (n)) == LUA_TVECTOR)
 #define lua_isthread(L,n)	(lua_type(L, (n)) == LUA_TTHREAD)
 #define lua_isnone(L,n)		(lua_type(L, (n)) == LUA_TNONE)
 #define lua_isnoneornil(L, n)	(lua_type(L, (n)) <= 0)
@@ -469,6 +487,11 @@ LUA_API void (lua_sethook) (lua_State *L, lua_Hook func, int mask, int count);
 LUA_API lua_Hook (lua_gethook) (lua_State *L);
 LUA_API int (lua_gethookmask) (lua_State *L);
 LUA_API int (lua_gethookcount) (lua_State *L);
+LUA_API int (lua_gethookcountleft) (lua_State *L);
+
+LUA_API void (lua_setinterrupt) (lua_State *L, lua_Hook func);
+LUA_API void (lua_interrupt) (lua_State *L);
+LUA_API void (lua_clearinterrupt) (lua_State *L);
 
 LUA_API int (lua_setcstacklimit) (lua_State *L, unsigned int limit);
 
@@ -794,6 +794,26 @@
 ** without modifying the main part of the file.
 */
 
+/*
+@@ LUAI_INLINECACHE enables per-instruction inline caches for OP_GETFIELD
+** and OP_SELF: each site remembers the hash node where it last found its
+** key and checks that node before doing a full lookup.
+** Define it as 0 to build the VM without the caches.
+*/
+#if !defined(LUAI_INLINECACHE)
+#define LUAI_INLINECACHE	1
+#endif
+
+/*
+@@ LUAI_FUSEOPS makes the code generator fuse common instruction pairs
+** (OP_GETFIELD/OP_GETFIELD, OP_GETTABUP/OP_GETFIELD, OP_GETTABUP/OP_CALL)
+** into superinstructions that skip one dispatch.
+** Define it as 0 to compile plain Lua 5.4 code.
+*/
+#if !defined(LUAI_FUSEOPS)
+#define LUAI_FUSEOPS	1
+#endif
+
 
 
 
@@ -38,6 +38,26 @@ LUAMOD_API int (luaopen_utf8) (lua_State *L);
 #define LUA_MATHLIBNAME	"math"
 LUAMOD_API int (luaopen_math) (lua_State *L);
 
+#define LUA_VECLIBNAME	"vector"
+LUAMOD_API int (luaopen_vector) (lua_State *L);
+
+#define LUA_BUFLIBNAME	"buffer"
+LUAMOD_API int (luaopen_buffer) (lua_State *L);
+
+/*
+** Typed numeric buffers: contiguous arrays of one element type, so
+** the host can read and fill them directly.
+*/
+#define LUA_BUFFERHANDLE	"buffer"
+
+#define LUA_BUFF32	0	/* float */
+#define LUA_BUFF64	1	/* double */
+#define LUA_BUFI32	2	/* 32-bit int */
+
+LUALIB_API void *(luaL_newbuffer) (lua_State *L, int type, size_t n);
+LUALIB_API void *(luaL_tobuffer) (lua_State *L, int idx, int *type,
+                                                size_t *n);
+
 #define LUA_DBLIBNAME	"debug"
 LUAMOD_API int (luaopen_debug) (lua_State *L);
 
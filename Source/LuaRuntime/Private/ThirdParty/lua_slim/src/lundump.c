@@ -146,6 +146,9 @@ static void loadCode (LoadState *S, Proto *f) {
   f->code = luaM_newvectorchecked(S->L, n, Instruction);
   f->sizecode = n;
   loadVector(S, f->code, n);
+#if LUAI_INLINECACHE
+  luaF_initcache(S->L, f);
+#endif
 }
 
 
@@ -307,6 +310,21 @@ static void checkHeader (LoadState *S) {
 }
 
 
+/*
+** Stripped chunks carry no source name; give them the name they were
+** loaded with, so their error messages match the text path.
+*/
+static void setsource (lua_State *L, Proto *f, TString *source) {
+  int i;
+  if (f->source == NULL) {
+    f->source = source;
+    luaC_objbarrier(L, f, source);
+  }
+  for (i = 0; i < f->sizep; i++)
+    setsource(L, f->p[i], source);
+}
+
+
 /*
 ** Load precompiled chunk.
 */
@@ -328,6 +346,8 @@ LClosure *luaU_undump(lua_State *L, ZIO *Z, const char *name) {
   cl->p = luaF_newproto(L);
   luaC_objbarrier(L, cl, cl->p);
   loadFunction(&S, cl->p, NULL);
+  if (cl->p->source == NULL)
+    setsource(L, cl->p, luaS_new(L, name));
   lua_assert(cl->nupvalues == cl->p->sizeupvalues);
   luai_verifycode(L, cl->p);
   return cl;
@@ -0,0 +1,184 @@
+/*
+** $Id: lveclib.c $
+** Library for 3-component vectors
+** See Copyright Notice in lua.h
+*/
+
+#define lveclib_c
+#define LUA_LIB
+
+#include "lprefix.h"
+
+
+#include <math.h>
+
+#include "lua.h"
+
+#include "lauxlib.h"
+#include "lualib.h"
+
+
+/* squared length under which 'normalize' gives the zero vector */
+#define VEC_SMALLSQ	(l_mathop(1e-8))
+
+
+static void checkvector (lua_State *L, int arg, lua_Number *v) {
+  if (!lua_tovector(L, arg, v))
+    luaL_typeerror(L, arg, "vector");
+}
+
+
+static lua_Number dot (const lua_Number *a, const lua_Number *b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+static int vec_new (lua_State *L) {
+  lua_Number x = luaL_optnumber(L, 1, 0);
+  lua_Number y = luaL_optnumber(L, 2, 0);
+  lua_Number z = luaL_optnumber(L, 3, 0);
+  lua_pushvector(L, x, y, z);
+  return 1;
+}
+
+
+static int vec_dot (lua_State *L) {
+  lua_Number a[3], b[3];
+  checkvector(L, 1, a);
+  checkvector(L, 2, b);
+  lua_pushnumber(L, dot(a, b));
+  return 1;
+}
+
+
+static int vec_cross (lua_State *L) {
+  lua_Number a[3], b[3];
+  checkvector(L, 1, a);
+  checkvector(L, 2, b);
+  lua_pushvector(L, a[1] * b[2] - a[2] * b[1],
+                    a[2] * b[0] - a[0] * b[2],
+                    a[0] * b[1] - a[1] * b[0]);
+  return 1;
+}
+
+
+static int vec_length (lua_State *L) {
+  lua_Number a[3];
+  checkvector(L, 1, a);
+  lua_pushnumber(L, l_mathop(sqrt)(dot(a, a)));
+  return 1;
+}
+
+
+static int vec_lengthsq (lua_State *L) {
+  lua_Number a[3];
+  checkvector(L, 1, a);
+  lua_pushnumber(L, dot(a, a));
+  return 1;
+}
+
+
+/* unit vector, or the zero vector if 'v' is too short to have a direction */
+static int vec_normalize (lua_State *L) {
+  lua_Number a[3], sq;
+  checkvector(L, 1, a);
+  sq = dot(a, a);
+  if (sq < VEC_SMALLSQ)
+    lua_pushvector(L, 0, 0, 0);
+  else {
+    lua_Number inv = 1 / l_mathop(sqrt)(sq);
+    lua_pushvector(L, a[0] * inv, a[1] * inv, a[2] * inv);
+  }
+  return 1;
+}
+
+
+static int vec_distance (lua_State *L) {
+  lua_Number a[3], b[3], d[3];
+  checkvector(L, 1, a);
+  checkvector(L, 2, b);
+  d[0] = a[0] - b[0];
+  d[1] = a[1] - b[1];
+  d[2] = a[2] - b[2];
+  lua_pushnumber(L, l_mathop(sqrt)(dot(d, d)));
+  return 1;
+}
+
+
+static int vec_lerp (lua_State *L) {
+  lua_Number a[3], b[3], t;
+  checkvector(L, 1, a);
+  checkvector(L, 2, b);
+  t = luaL_checknumber(L, 3);
+  lua_pushvector(L, a[0] + (b[0] - a[0]) * t,
+                    a[1] + (b[1] - a[1]) * t,
+                    a[2] + (b[2] - a[2]) * t);
+  return 1;
+}
+
+
+static int vec_tostring (lua_State *L) {
+  lua_Number a[3];
+  checkvector(L, 1, a);
+  lua_pushfstring(L, "vector(%f, %f, %f)", a[0], a[1], a[2]);
+  return 1;
+}
+
+
+static int vec_newindex (lua_State *L) {
+  return luaL_error(L, "cannot assign to a vector (vectors are immutable)");
+}
+
+
+static const luaL_Reg veclib[] = {
+  {"new", vec_new},
+  {"dot", vec_dot},
+  {"cross", vec_cross},
+  {"length", vec_length},
+  {"lengthsq", vec_lengthsq},
+  {"normalize", vec_normalize},
+  {"distance", vec_distance},
+  {"lerp", vec_lerp},
+  /* placeholders */
+  {"zero", NULL},
+  {NULL, NULL}
+};
+
+
+/*
+** metamethods; arithmetic and equality are built into the core
+*/
+static const luaL_Reg vecmetamethods[] = {
+  {"__tostring", vec_tostring},
+  {"__newindex", vec_newindex},
+  {"__index", NULL},  /* placeholder */
+  {"__name", NULL},  /* placeholder */
+  {NULL, NULL}
+};
+
+
+/*
+** Set the metatable shared by all vectors, so that methods resolve
+** to the library ('v:length()').
+*/
+static void createmetatable (lua_State *L) {
+  luaL_newlibtable(L, vecmetamethods);
+  luaL_setfuncs(L, vecmetamethods, 0);
+  lua_pushliteral(L, "vector");
+  lua_setfield(L, -2, "__name");
+  lua_pushvalue(L, -2);  /* library */
+  lua_setfield(L, -2, "__index");
+  lua_pushvector(L, 0, 0, 0);  /* dummy vector */
+  lua_pushvalue(L, -2);
+  lua_setmetatable(L, -2);  /* set table as metatable for vectors */
+  lua_pop(L, 2);  /* pop dummy vector and metatable */
+}
+
+
+LUAMOD_API int luaopen_vector (lua_State *L) {
+  luaL_newlib(L, veclib);
+  lua_pushvector(L, 0, 0, 0);
+  lua_setfield(L, -2, "zero");
+  createmetatable(L);
+  return 1;
+}
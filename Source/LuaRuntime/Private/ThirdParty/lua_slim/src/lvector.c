@@ -0,0 +1,102 @@
+/*
+** $Id: lvector.c $
+** Built-in 3-component vectors
+** See Copyright Notice in lua.h
+*/
+
+#define lvector_c
+#define LUA_CORE
+
+#include "lprefix.h"
+
+
+#include "lua.h"
+
+#include "lgc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "lvector.h"
+#include "lvm.h"
+
+
+Vector *luaR_new (lua_State *L, lua_Number x, lua_Number y, lua_Number z) {
+  GCObject *o = luaC_newobj(L, LUA_VVECTOR, sizeof(Vector));
+  Vector *v = gco2vec(o);
+  v->v[0] = x;
+  v->v[1] = y;
+  v->v[2] = z;
+  return v;
+}
+
+
+/*
+** Component index (0-2) named by 'key' ("x", "y" or "z"), or -1.
+*/
+int luaR_component (const TValue *key) {
+  if (ttisshrstring(key)) {
+    TString *ts = tsvalue(key);
+    if (ts->shrlen == 1) {
+      switch (getstr(ts)[0]) {
+        case 'x': return 0;
+        case 'y': return 1;
+        case 'z': return 2;
+      }
+    }
+  }
+  return -1;
+}
+
+
+/*
+** Components of an arithmetic operand: a vector's own, or a number
+** broadcast into 'buff'. Returns NULL for anything else.
+*/
+static const lua_Number *operand (const TValue *o, lua_Number *buff) {
+  lua_Number n;
+  if (ttisvector(o))
+    return vecvalue(o)->v;
+  else if (tonumberns(o, n)) {
+    buff[0] = buff[1] = buff[2] = n;
+    return buff;
+  }
+  else return NULL;
+}
+
+
+/*
+** Arithmetic with at least one vector operand: component-wise '+',
+** '-', '*' and '/' (a number operand applies to every component) and
+** unary minus. Stores the new vector in 'res' and returns 1, or returns
+** 0 if the operation is not defined for these operands.
+*/
+int luaR_arith (lua_State *L, const TValue *p1, const TValue *p2,
+                              StkId res, TMS event) {
+  lua_Number b1[3], b2[3], r[3];
+  const lua_Number *a = operand(p1, b1);
+  const lua_Number *b = operand(p2, b2);
+  int i;
+  if (a == NULL || b == NULL)
+    return 0;
+  switch (event) {
+    case TM_ADD:
+      for (i = 0; i < 3; i++) r[i] = luai_numadd(L, a[i], b[i]);
+      break;
+    case TM_SUB:
+      for (i = 0; i < 3; i++) r[i] = luai_numsub(L, a[i], b[i]);
+      break;
+    case TM_MUL:
+      for (i = 0; i < 3; i++) r[i] = luai_nummul(L, a[i], b[i]);
+      break;
+    case TM_DIV:
+      for (i = 0; i < 3; i++) r[i] = luai_numdiv(L, a[i], b[i]);
+      break;
+    case TM_UNM:
+      for (i = 0; i < 3; i++) r[i] = luai_numunm(L, a[i]);
+      break;
+    default:
+      return 0;
+  }
+  setvec2s(L, res, luaR_new(L, r[0], r[1], r[2]));
+  luaC_checkGC(L);
+  return 1;
+}
@@ -0,0 +1,28 @@
+/*
+** $Id: lvector.h $
+** Built-in 3-component vectors
+** See Copyright Notice in lua.h
+*/
+
+#ifndef lvector_h
+#define lvector_h
+
+
+#include "lobject.h"
+#include "ltm.h"
+
+
+/* raw equality of two vectors (component-wise, like numbers) */
+#define luaR_equal(a,b)	(luai_numeq((a)->v[0], (b)->v[0]) && \
+                         luai_numeq((a)->v[1], (b)->v[1]) && \
+                         luai_numeq((a)->v[2], (b)->v[2]))
+
+
+LUAI_FUNC Vector *luaR_new (lua_State *L, lua_Number x, lua_Number y,
+                                          lua_Number z);
+LUAI_FUNC int luaR_component (const TValue *key);
+LUAI_FUNC int luaR_arith (lua_State *L, const TValue *p1, const TValue *p2,
+                                        StkId res, TMS event);
+
+
+#endif
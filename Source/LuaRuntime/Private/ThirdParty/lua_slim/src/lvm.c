@@ -28,6 +28,7 @@
 #include "lstring.h"
 #include "ltable.h"
 #include "ltm.h"
+#include "lvector.h"
 #include "lvm.h"
 
 
@@ -293,6 +294,13 @@ void luaV_finishget (lua_State *L, const TValue *t, TValue *key, StkId val,
   for (loop = 0; loop < MAXTAGLOOP; loop++) {
     if (slot == NULL) {  /* 't' is not a table? */
       lua_assert(!ttistable(t));
+      if (ttisvector(t)) {  /* component access needs no metamethod */
+        int c = luaR_component(key);
+        if (c >= 0) {
+          setfltvalue(s2v(val), vecvalue(t)->v[c]);
+          return;
+        }
+      }
       tm = luaT_gettmbyobj(L, t, TM_INDEX);
       if (l_unlikely(notm(tm)))
         luaG_typeerror(L, t, "index");  /* no metamethod */
@@ -590,6 +598,7 @@ int luaV_equalobj (lua_State *L, const TValue *t1, const TValue *t2) {
     case LUA_VLCF: return fvalue(t1) == fvalue(t2);
     case LUA_VSHRSTR: return eqshrstr(tsvalue(t1), tsvalue(t2));
     case LUA_VLNGSTR: return luaS_eqlngstr(tsvalue(t1), tsvalue(t2));
+    case LUA_VVECTOR: return luaR_equal(vecvalue(t1), vecvalue(t2));
     case LUA_VUSERDATA: {
       if (uvalue(t1) == uvalue(t2)) return 1;
       else if (L == NULL) return 0;
@@ -808,6 +817,34 @@ static void pushclosure (lua_State *L, Proto *p, UpVal **encup, StkId base,
 }
 
 
+#if LUAI_INLINECACHE
+/*
+** Raw 't[key]' for a short-string 'key' through the inline cache 'c' of
+** the current instruction, which holds the index + 1 of the node where
+** this instruction last found its key (0 if none). A cached node is used
+** only if it still holds 'key'; otherwise do the full lookup and remember
+** where it found the key.
+*/
+l_sinline const TValue *icgetshortstr (Table *t, TString *key,
+                                        unsigned short *c) {
+  const TValue *slot;
+  int idx = *c;
+  if (idx != 0 && idx <= sizenode(t)) {
+    Node *n = gnode(t, idx - 1);
+    if (keyisshrstr(n) && keystrval(n) == key)
+      return gval(n);
+  }
+  slot = luaH_getshortstr(t, key);
+  if (!isabstkey(slot)) {
+    size_t pos = cast_sizet(cast(const Node *, slot) - t->node);
+    if (pos < USHRT_MAX)
+      *c = cast(unsigned short, pos + 1);
+  }
+  return slot;
+}
+#endif
+
+
 /*
 ** finish execution of an opcode interrupted by a yield
 */
@@ -823,7 +860,8 @@ void luaV_finishOp (lua_State *L) {
     }
     case OP_UNM: case OP_BNOT: case OP_LEN:
     case OP_GETTABUP: case OP_GETTABLE: case OP_GETI:
-    case OP_GETFIELD: case OP_SELF: {
+    case OP_GETFIELD: case OP_SELF:
+    case OP_GETFIELDF: case OP_GETTABUPF: case OP_GETTABUPC: {
       setobjs2s(L, base + GETARG_A(inst), --L->top.p);
       break;
     }
@@ -1047,6 +1085,68 @@ void luaV_finishOp (lua_State *L) {
   }  \
   docondjump(); }
 
+
+/*
+** Raw access 't[k]' for a short-string key 'k', following the
+** conventions of 'luaV_fastget'. With inline caches, goes through the
+** cache of the current instruction.
+*/
+#if LUAI_INLINECACHE
+#define fieldget(L,t,k,slot) \
+  (!ttistable(t)  \
+   ? (slot = NULL, 0)  \
+   : (slot = icgetshortstr(hvalue(t), k, icslot(cl, pc)),  \
+      !isempty(slot)))
+#else
+#define fieldget(L,t,k,slot)	luaV_fastget(L,t,k,slot,luaH_getshortstr)
+#endif
+
+
+/*
+** Bodies of the opcodes that can start or end a fused pair
+*/
+#define op_gettabup(L) {  \
+  StkId ra = RA(i);  \
+  const TValue *slot;  \
+  TValue *upval = cl->upvals[GETARG_B(i)]->v.p;  \
+  TValue *rc = KC(i);  \
+  TString *key = tsvalue(rc);  /* key must be a short string */  \
+  if (luaV_fastget(L, upval, key, slot, luaH_getshortstr)) {  \
+    setobj2s(L, ra, slot);  \
+  }  \
+  else  \
+    Protect(luaV_finishget(L, upval, rc, ra, slot)); }
+
+
+#define op_getfield(L) {  \
+  StkId ra = RA(i);  \
+  const TValue *slot;  \
+  TValue *rb = vRB(i);  \
+  TValue *rc = KC(i);  \
+  TString *key = tsvalue(rc);  /* key must be a short string */  \
+  if (fieldget(L, rb, key, slot)) {  \
+    setobj2s(L, ra, slot);  \
+  }  \
+  else  \
+    Protect(luaV_finishget(L, rb, rc, ra, slot)); }
+
+
+#define op_call(L) {  \
+  StkId ra = RA(i);  \
+  CallInfo *newci;  \
+  int b = GETARG_B(i);  \
+  int nresults = GETARG_C(i) - 1;  \
+  if (b != 0)  /* fixed number of arguments? */  \
+    L->top.p = ra + b;  /* top signals number of arguments */  \
+  /* else previous instruction set top */  \
+  savepc(L);  /* in case of errors */  \
+  if ((newci = luaD_precall(L, ra, nresults)) == NULL)  \
+    updatetrap(ci);  /* C call; nothing else to be done */  \
+  else {  /* Lua call: run function in this same C frame */  \
+    ci = newci;  \
+    goto startfunc;  \
+  } }
+
 /* }================================================================== */
 
 
@@ -1074,8 +1174,14 @@ void luaV_finishOp (lua_State *L) {
 
 #define updatetrap(ci)  (trap = ci->u.l.trap)
 
+/* 'updatetrap' that also notices a pending 'lua_interrupt' */
+#define updatetrapi(ci)  (trap = ci->u.l.trap | G(L)->interrupt)
+
 #define updatebase(ci)	(base = ci->func.p + 1)
 
+/* inline cache of the instruction being executed */
+#define icslot(cl,pc)	((cl)->p->icache + ((pc) - 1 - (cl)->p->code))
+
 
 #define updatestack(ci)  \
 	{ if (l_unlikely(trap)) { updatebase(ci); ra = RA(i); } }
@@ -1085,7 +1191,7 @@ void luaV_finishOp (lua_State *L) {
 ** Execute a jump instruction. The 'updatetrap' allows signals to stop
 ** tight loops. (Without it, the local copy of 'trap' could never change.)
 */
-#define dojump(ci,i,e)	{ pc += GETARG_sJ(i) + e; updatetrap(ci); }
+#define dojump(ci,i,e)	{ pc += GETARG_sJ(i) + e; updatetrapi(ci); }
 
 
 /* for test instructions, execute the jump instruction that follows it */
@@ -1147,6 +1253,17 @@ void luaV_finishOp (lua_State *L) {
 #define vmcase(l)	case l:
 #define vmbreak		break
 
+/*
+** run the second instruction of a fused pair with no dispatch; when
+** 'trap' is set (hooks, moved stack) leave it to the regular path
+*/
+#define vmfuse(op2) {  \
+  if (l_unlikely(trap)) { vmbreak; }  \
+  i = *(pc++);  \
+  lua_assert(isIT(i) || (cast_void(L->top.p = base), 1));  \
+  op2;  \
+  vmbreak; }
+
 
 void luaV_execute (lua_State *L, CallInfo *ci) {
   LClosure *cl;
@@ -1158,7 +1275,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
 #include "ljumptab.h"
 #endif
  startfunc:
-  trap = L->hookmask;
+  trap = L->hookmask | G(L)->interrupt;
  returning:  /* trap already set */
   cl = ci_func(ci);
   k = cl->p->k;
@@ -1247,16 +1364,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         vmbreak;
       }
       vmcase(OP_GETTABUP) {
-        StkId ra = RA(i);
-        const TValue *slot;
-        TValue *upval = cl->upvals[GETARG_B(i)]->v.p;
-        TValue *rc = KC(i);
-        TString *key = tsvalue(rc);  /* key must be a short string */
-        if (luaV_fastget(L, upval, key, slot, luaH_getshortstr)) {
-          setobj2s(L, ra, slot);
-        }
-        else
-          Protect(luaV_finishget(L, upval, rc, ra, slot));
+        op_gettabup(L);
         vmbreak;
       }
       vmcase(OP_GETTABLE) {
@@ -1290,16 +1398,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         vmbreak;
       }
       vmcase(OP_GETFIELD) {
-        StkId ra = RA(i);
-        const TValue *slot;
-        TValue *rb = vRB(i);
-        TValue *rc = KC(i);
-        TString *key = tsvalue(rc);  /* key must be a short string */
-        if (luaV_fastget(L, rb, key, slot, luaH_getshortstr)) {
-          setobj2s(L, ra, slot);
-        }
-        else
-          Protect(luaV_finishget(L, rb, rc, ra, slot));
+        op_getfield(L);
         vmbreak;
       }
       vmcase(OP_SETTABUP) {
@@ -1384,6 +1483,30 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         TValue *rc = RKC(i);
         TString *key = tsvalue(rc);  /* key must be a string */
         setobj2s(L, ra + 1, rb);
+#if LUAI_INLINECACHE
+        if (ttistable(rb) && key->tt == LUA_VSHRSTR) {
+          Table *h = hvalue(rb);
+          unsigned short *c = icslot(cl, pc);
+          slot = icgetshortstr(h, key, c);
+          if (isempty(slot) && h->metatable != NULL) {
+            /* method in a class table: cache its node through '__index' */
+            const TValue *tm = fasttm(L, h->metatable, TM_INDEX);
+            if (tm != NULL && ttistable(tm)) {
+              const TValue *mslot = icgetshortstr(hvalue(tm), key, c);
+              if (!isempty(mslot)) {
+                setobj2s(L, ra, mslot);
+                vmbreak;
+              }
+            }
+          }
+          if (!isempty(slot)) {
+            setobj2s(L, ra, slot);
+          }
+          else
+            Protect(luaV_finishget(L, rb, rc, ra, slot));
+          vmbreak;
+        }
+#endif
         if (luaV_fastget(L, rb, key, slot, luaH_getstr)) {
           setobj2s(L, ra, slot);
         }
@@ -1671,20 +1794,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         vmbreak;
       }
       vmcase(OP_CALL) {
-        StkId ra = RA(i);
-        CallInfo *newci;
-        int b = GETARG_B(i);
-        int nresults = GETARG_C(i) - 1;
-        if (b != 0)  /* fixed number of arguments? */
-          L->top.p = ra + b;  /* top signals number of arguments */
-        /* else previous instruction set top */
-        savepc(L);  /* in case of errors */
-        if ((newci = luaD_precall(L, ra, nresults)) == NULL)
-          updatetrap(ci);  /* C call; nothing else to be done */
-        else {  /* Lua call: run function in this same C frame */
-          ci = newci;
-          goto startfunc;
-        }
+        op_call(L);
         vmbreak;
       }
       vmcase(OP_TAILCALL) {
@@ -1797,7 +1907,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         }
         else if (floatforloop(ra))  /* float loop */
           pc -= GETARG_Bx(i);  /* jump back */
-        updatetrap(ci);  /* allows a signal to break the loop */
+        updatetrapi(ci);  /* allows a signal to break the loop */
         vmbreak;
       }
       vmcase(OP_FORPREP) {
@@ -1839,6 +1949,7 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         if (!ttisnil(s2v(ra + 4))) {  /* continue loop? */
           setobjs2s(L, ra + 2, ra + 4);  /* save control variable */
           pc -= GETARG_Bx(i);  /* jump back */
+          updatetrapi(ci);  /* allows an interrupt to break the loop */
         }
         vmbreak;
       }}
@@ -1892,6 +2003,18 @@ void luaV_execute (lua_State *L, CallInfo *ci) {
         lua_assert(0);
         vmbreak;
       }
+      vmcase(OP_GETFIELDF) {
+        op_getfield(L);
+        vmfuse(op_getfield(L));
+      }
+      vmcase(OP_GETTABUPF) {
+        op_gettabup(L);
+        vmfuse(op_getfield(L));
+      }
+      vmcase(OP_GETTABUPC) {
+        op_gettabup(L);
+        vmfuse(op_call(L));
+      }
     }
   }
 }
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LuaSandbox.h"
+#include <type_traits>
+
+struct lua_State;
+
+/** Result of a bound call in storage owned by the binding, so pushing it needs no C++ object on the stack. */
+struct FLuaBindingResult
+{
+    enum class EKind : uint8
+    {
+        Boolean,
+        Integer,
+        Number,
+        String,
+        Vector,
+        Table
+    };
+
+    EKind Kind = EKind::Boolean;
+    bool bBoolean = false;
+    int64 Integer = 0;
+    /** Number, vector components, or the fields of a Table result. */
+    double Numbers[3] = { 0.0, 0.0, 0.0 };
+    /** Field names of a Table result (static strings). */
+    const char* FieldNames[3] = { nullptr, nullptr, nullptr };
+    int32 NumFields = 0;
+    TArray<ANSICHAR> Utf8;
+};
+
+/**
+ * Typed native bindings: ULuaSandbox::Bind("dist", &MyFunc) exposes a C++ function or lambda to Lua. Argument
+ * reads and the result push are generated per signature at compile time, so a call does no boxing into FLuaValue
+ * and no type switch.
+ *
+ * Supported parameter and return types: bool, integers, float, double, FString, FName, FUtf8StringView (argument
+ * only; valid during the call), FVector (the built-in Lua vector type; tables with x/y/z fields are accepted as
+ * arguments), FVector2D and FRotator (tables with x/y and pitch/yaw/roll fields). Add more by specializing TLuaStack. A wrong argument raises a Lua error such as "bad argument #1 to 'dist'
+ * (number expected, got nil)"; extra arguments are ignored.
+ *
+ * Lua is built as C, so its errors unwind with longjmp and skip C++ destructors. Argument reads therefore never
+ * raise (raw, non-allocating reads only), and results are staged into an FLuaBindingResult that is pushed once the
+ * arguments and the returned value are destroyed. For the same reason string arguments must be Lua strings (numbers
+ * are not converted, as that would allocate).
+ */
+namespace LuaBinding
+{
+    // Stack primitives behind the templates (the Lua headers are private to this module)
+    LUARUNTIME_API bool ToBoolean(lua_State* L, int Index);
+    LUARUNTIME_API bool ToInteger(lua_State* L, int Index, int64& Out);
+    LUARUNTIME_API bool ToNumber(lua_State* L, int Index, double& Out);
+    LUARUNTIME_API bool ToUtf8View(lua_State* L, int Index, FUtf8StringView& Out);
+    LUARUNTIME_API bool ToString(lua_State* L, int Index, FString& Out);
+    LUARUNTIME_API bool ToName(lua_State* L, int Index, FName& Out);
+    LUARUNTIME_API bool ToVector(lua_State* L, int Index, FVector& Out);
+    LUARUNTIME_API bool ToVector2D(lua_State* L, int Index, FVector2D& Out);
+    LUARUNTIME_API bool ToRotator(lua_State* L, int Index, FRotator& Out);
+
+    LUARUNTIME_API void StageBoolean(FLuaBindingResult& Out, bool Value);
+    LUARUNTIME_API void StageInteger(FLuaBindingResult& Out, int64 Value);
+    LUARUNTIME_API void StageNumber(FLuaBindingResult& Out, double Value);
+    LUARUNTIME_API void StageString(FLuaBindingResult& Out, const FString& Value);
+    LUARUNTIME_API void StageName(FLuaBindingResult& Out, FName Value);
+    LUARUNTIME_API void StageVector(FLuaBindingResult& Out, const FVector& Value);
+    LUARUNTIME_API void StageVector2D(FLuaBindingResult& Out, const FVector2D& Value);
+    LUARUNTIME_API void StageRotator(FLuaBindingResult& Out, const FRotator& Value);
+
+    /** Push a staged result; may raise a Lua error, so call it with no C++ objects alive on the stack. */
+    LUARUNTIME_API void PushResult(lua_State* L, const FLuaBindingResult& Result);
+
+    /** The binding object of the running native function, or null if it was not bound in this state. */
+    LUARUNTIME_API FLuaNativeBinding* GetRunningBinding(lua_State* L);
+    /** Raise "bad argument #Arg (Expected expected, got ...)"; does not return. */
+    LUARUNTIME_API int RaiseArgError(lua_State* L, int Arg, const char* Expected);
+    /** Raise an error for a closure called without its binding; does not return. */
+    LUARUNTIME_API int RaiseUnboundError(lua_State* L);
+}
+
+/**
+ * Marshaling for one C++ type: Get reads stack slot Index (false on a type mismatch) and must not raise a Lua error;
+ * Stage converts a result into an FLuaBindingResult.
+ */
+template <typename T, typename Enable = void>
+struct TLuaStack
+{
+    static_assert(sizeof(T) == 0, "Type cannot be marshaled to Lua; specialize TLuaStack for it");
+};
+
+template <>
+struct TLuaStack<bool>
+{
+    static constexpr const char* TypeName = "boolean";
+    static bool Get(lua_State* L, int Index, bool& Out) { Out = LuaBinding::ToBoolean(L, Index); return true; }
+    static void Stage(FLuaBindingResult& Out, bool Value) { LuaBinding::StageBoolean(Out, Value); }
+};
+
+template <typename T>
+struct TLuaStack<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+{
+    static constexpr const char* TypeName = "integer";
+    static bool Get(lua_State* L, int Index, T& Out)
+    {
+        int64 Value = 0;
+        if (!LuaBinding::ToInteger(L, Index, Value)) return false;
+        Out = (T)Value;
+        return true;
+    }
+    static void Stage(FLuaBindingResult& Out, T Value) { LuaBinding::StageInteger(Out, (int64)Value); }
+};
+
+template <typename T>
+struct TLuaStack<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+    static constexpr const char* TypeName = "number";
+    static bool Get(lua_State* L, int Index, T& Out)
+    {
+        double Value = 0.0;
+        if (!LuaBinding::ToNumber(L, Index, Value)) return false;
+        Out = (T)Value;
+        return true;
+    }
+    static void Stage(FLuaBindingResult& Out, T Value) { LuaBinding::StageNumber(Out, (double)Value); }
+};
+
+template <>
+struct TLuaStack<FUtf8StringView>
+{
+    static constexpr const char* TypeName = "string";
+    static bool Get(lua_State* L, int Index, FUtf8StringView& Out) { return LuaBinding::ToUtf8View(L, Index, Out); }
+};
+
+template <>
+struct TLuaStack<FString>
+{
+    static constexpr const char* TypeName = "string";
+    static bool Get(lua_State* L, int Index, FString& Out) { return LuaBinding::ToString(L, Index, Out); }
+    static void Stage(FLuaBindingResult& Out, const FString& Value) { LuaBinding::StageString(Out, Value); }
+};
+
+template <>
+struct TLuaStack<FName>
+{
+    static constexpr const char* TypeName = "string";
+    static bool Get(lua_State* L, int Index, FName& Out) { return LuaBinding::ToName(L, Index, Out); }
+    static void Stage(FLuaBindingResult& Out, FName Value) { LuaBinding::StageName(Out, Value); }
+};
+
+template <>
+struct TLuaStack<FVector>
+{
+    static constexpr const char* TypeName = "vector";
+    static bool Get(lua_State* L, int Index, FVector& Out) { return LuaBinding::ToVector(L, Index, Out); }
+    static void Stage(FLuaBindingResult& Out, const FVector& Value) { LuaBinding::StageVector(Out, Value); }
+};
+
+template <>
+struct TLuaStack<FVector2D>
+{
+    static constexpr const char* TypeName = "vector2d";
+    static bool Get(lua_State* L, int Index, FVector2D& Out) { return LuaBinding::ToVector2D(L, Index, Out); }
+    static void Stage(FLuaBindingResult& Out, const FVector2D& Value) { LuaBinding::StageVector2D(Out, Value); }
+};
+
+template <>
+struct TLuaStack<FRotator>
+{
+    static constexpr const char* TypeName = "rotator";
+    static bool Get(lua_State* L, int Index, FRotator& Out) { return LuaBinding::ToRotator(L, Index, Out); }
+    static void Stage(FLuaBindingResult& Out, const FRotator& Value) { LuaBinding::StageRotator(Out, Value); }
+};
+
+namespace LuaBinding
+{
+    template <typename FuncType>
+    struct TNativeBinding : public FLuaNativeBinding
+    {
+        template <typename InFuncType>
+        explicit TNativeBinding(InFuncType&& InFunc) : Func(Forward<InFuncType>(InFunc)) {}
+
+        FuncType Func;
+        FLuaBindingResult Result;
+    };
+
+    template <typename FuncType, typename Ret, typename... Args>
+    struct TInvoker
+    {
+        // Number of results (staged in OutResult), or minus the position of the first bad argument
+        template <int... Indices>
+        static int Call(lua_State* L, FuncType& Func, FLuaBindingResult& OutResult, TIntegerSequence<int, Indices...>)
+        {
+            TTuple<std::decay_t<Args>...> Values;
+            int BadArg = 0;
+            ((void)(BadArg == 0 && !TLuaStack<std::decay_t<Args>>::Get(L, Indices + 1, Values.template Get<Indices>()) && (BadArg = Indices + 1)), ...);
+            if (BadArg != 0)
+            {
+                return -BadArg;
+            }
+
+            if constexpr (std::is_void_v<Ret>)
+            {
+                Invoke(Func, static_cast<Args&&>(Values.template Get<Indices>())...);
+                return 0;
+            }
+            else
+            {
+                TLuaStack<std::decay_t<Ret>>::Stage(OutResult, Invoke(Func, static_cast<Args&&>(Values.template Get<Indices>())...));
+                return 1;
+            }
+        }
+
+        static int Thunk(lua_State* L)
+        {
+            FLuaNativeBinding* Binding = GetRunningBinding(L);
+            if (!Binding)
+            {
+                return RaiseUnboundError(L);
+            }
+
+            // Lua errors unwind without running destructors, so they are raised (and results pushed) only once the
+            // arguments and the returned value are gone; this frame holds nothing but POD
+            TNativeBinding<FuncType>* Native = static_cast<TNativeBinding<FuncType>*>(Binding);
+            const int Result = Call(L, Native->Func, Native->Result, TMakeIntegerSequence<int, sizeof...(Args)>());
+            if (Result < 0)
+            {
+                static constexpr const char* TypeNames[] = { TLuaStack<std::decay_t<Args>>::TypeName..., nullptr };
+                return RaiseArgError(L, -Result, TypeNames[-Result - 1]);
+            }
+            if (Result > 0)
+            {
+                PushResult(L, Native->Result);
+            }
+            return Result;
+        }
+    };
+
+    /** Signature of a function pointer or functor (lambda). */
+    template <typename FuncType>
+    struct TCallableTraits : TCallableTraits<decltype(&FuncType::operator())>
+    {
+    };
+
+    template <typename Ret, typename... Args>
+    struct TCallableTraits<Ret(*)(Args...)>
+    {
+        template <typename FuncType>
+        using TInvokerFor = TInvoker<FuncType, Ret, Args...>;
+    };
+
+    template <typename Class, typename Ret, typename... Args>
+    struct TCallableTraits<Ret(Class::*)(Args...)> : TCallableTraits<Ret(*)(Args...)>
+    {
+    };
+
+    template <typename Class, typename Ret, typename... Args>
+    struct TCallableTraits<Ret(Class::*)(Args...) const> : TCallableTraits<Ret(*)(Args...)>
+    {
+    };
+}
+
+template <typename FuncType>
+bool ULuaSandbox::Bind(const FString& Name, FuncType&& Func)
+{
+    using FDecayed = std::decay_t<FuncType>;
+    using FInvoker = typename LuaBinding::TCallableTraits<FDecayed>::template TInvokerFor<FDecayed>;
+    return BindNative(Name, MakeUnique<LuaBinding::TNativeBinding<FDecayed>>(Forward<FuncType>(Func)), &FInvoker::Thunk);
+}
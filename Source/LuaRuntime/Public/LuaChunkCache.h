@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "LuaChunkCache.generated.h"
+
+struct lua_State;
+
+USTRUCT(BlueprintType)
+struct FLuaChunkCacheStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Hits = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Misses = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Evictions = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 NumEntries = 0;
+
+    /** Bytes held by cached bytecode. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 BytecodeBytes = 0;
+
+    /** Hits / (Hits + Misses), 0 when nothing was loaded yet. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    float HitRate = 0.0f;
+};
+
+/**
+ * Process-wide cache of compiled chunks keyed by a hash of the UTF-8 source and chunk name.
+ * On a miss the source is compiled in text-only mode and the resulting function is dumped to bytecode;
+ * on a hit that bytecode is loaded directly, skipping the lexer and parser.
+ * Cached bytecode is only ever produced by this cache, so user code can never inject binary chunks.
+ */
+class LUARUNTIME_API FLuaChunkCache
+{
+public:
+    static FLuaChunkCache& Get();
+
+    /** Push the compiled chunk on L's stack. Returns the same status codes as luaL_loadbufferx. */
+    int Load(lua_State* L, const char* Source, int32 Len, const char* ChunkName);
+
+    FLuaChunkCacheStats GetStats() const;
+    void Empty();
+
+    /** lua_Writer for lua_dump that appends to the TArray<uint8> passed as UserData. */
+    static int WriteBytecode(lua_State* L, const void* Data, size_t Size, void* UserData);
+
+private:
+    struct FKey
+    {
+        uint64 Hash = 0;
+        uint32 Crc = 0;
+        int32 Len = 0;
+
+        bool operator==(const FKey& Other) const { return Hash == Other.Hash && Crc == Other.Crc && Len == Other.Len; }
+        friend uint32 GetTypeHash(const FKey& Key) { return HashCombine(GetTypeHash(Key.Hash), Key.Crc); }
+    };
+
+    struct FEntry
+    {
+        TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Bytecode;
+        uint64 LastUse = 0;
+    };
+
+    void Insert(const FKey& Key, TArray<uint8>&& Bytecode, int64 MaxBytes);
+
+    mutable FCriticalSection Lock;
+    TMap<FKey, FEntry> Entries;
+    uint64 UseCounter = 0;
+    int64 BytecodeBytes = 0;
+    int64 Hits = 0;
+    int64 Misses = 0;
+    int64 Evictions = 0;
+};
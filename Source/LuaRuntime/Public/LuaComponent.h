@@ -5,8 +5,12 @@
 #include "LuaSandbox.h"
 #include "LuaComponent.generated.h"
 
+struct FLuaTickBatch;
+class ULuaRuntimeSubsystem;
+
 /**
  * ULuaComponent binds an Actor to a Lua sandbox and can run a file or inline code on BeginPlay.
+ * With bEnableLuaTick, components sharing a sandbox are ticked together by one Lua call per frame (see LuaTickFunction).
  */
 UCLASS(ClassGroup=(Lua), BlueprintType, Blueprintable, meta=(BlueprintSpawnableComponent))
 class LUARUNTIME_API ULuaComponent : public UActorComponent
@@ -62,6 +66,35 @@ public: // Configuration
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua")
     FName NamedSandbox;
 
+public: // Batched tick
+    /**
+     * Tick from Lua without a Blueprint Tick: every frame the subsystem calls LuaTickFunction(dt, actors) once per
+     * sandbox and tick group, where actors is an array with one table per due component ({ id, name, dt }, dt being
+     * the time since that actor last ticked). Scripts can keep per-actor state in those tables.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick")
+    bool bEnableLuaTick = false;
+
+    /** Global Lua function (or dotted path) receiving the batch. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick", meta=(EditCondition="bEnableLuaTick"))
+    FString LuaTickFunction = TEXT("update");
+
+    /** Components in different tick groups are batched separately. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick", meta=(EditCondition="bEnableLuaTick"))
+    TEnumAsByte<ETickingGroup> LuaTickGroup = TG_PrePhysics;
+
+    /** Include this actor every N frames. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick", meta=(EditCondition="bEnableLuaTick", ClampMin="1", UIMin="1"))
+    int32 LuaTickInterval = 1;
+
+    /** Beyond this distance from every local player's view point, tick every LuaTickFarInterval frames instead (0 = off). */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick", meta=(EditCondition="bEnableLuaTick", ClampMin="0", UIMin="0"))
+    float LuaTickNearDistance = 0.0f;
+
+    /** Frames between ticks when far away; 0 stops ticking until the actor comes near again. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua|Tick", meta=(EditCondition="bEnableLuaTick", ClampMin="0", UIMin="0"))
+    int32 LuaTickFarInterval = 8;
+
 public: // Runtime API
     /** Ensure a sandbox exists (named via subsystem or private) and return it. */
     UFUNCTION(BlueprintCallable, Category="Lua")
@@ -79,7 +112,19 @@ public: // Runtime API
     UFUNCTION(BlueprintCallable, Category="Lua")
     void ResetSandbox();
 
+    /** Join or leave the batched Lua tick; settings changed at runtime take effect when it is re-enabled. */
+    UFUNCTION(BlueprintCallable, Category="Lua|Tick")
+    void SetLuaTickEnabled(bool bEnabled);
+
 private:
+    friend class ULuaRuntimeSubsystem;
+
+    ULuaRuntimeSubsystem* GetRuntimeSubsystem() const;
+
+    /** Batch this component ticks in, and its id there (0 when not ticking). */
+    TWeakPtr<FLuaTickBatch> LuaTickBatch;
+    int32 LuaTickId = 0;
+
     /** Holds a private sandbox when NamedSandbox is not set. */
     UPROPERTY(Transient)
     ULuaSandbox* PrivateSandbox = nullptr;
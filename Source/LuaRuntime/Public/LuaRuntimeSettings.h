@@ -42,8 +42,102 @@ public: // Execution Defaults
     UPROPERTY(EditAnywhere, Config, Category="Execution", meta=(ClampMin="1", UIMin="1"))
     int32 DefaultTimeoutMs;
 
-    /** Default hook interval (instructions) for timeout checks. */
+    /**
+     * Default instruction budget per call (VM instructions, 0 = unlimited). Deterministic, unlike the timeout;
+     * sandboxes can override it with SetInstructionBudget.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Execution", meta=(ClampMin="0", UIMin="0"))
+    int64 DefaultInstructionBudget;
+
+    /** Default instruction budget per sandbox per frame, shared by all calls in that frame (0 = unlimited). */
+    UPROPERTY(EditAnywhere, Config, Category="Execution", meta=(ClampMin="0", UIMin="0"))
+    int64 DefaultFrameInstructionBudget;
+
+    /** Default hook interval (instructions) for timeout checks when the clock is polled (watchdog off or unavailable). */
     UPROPERTY(EditAnywhere, Config, Category="Execution", meta=(ClampMin="1", UIMin="1"))
     int32 DefaultHookInterval;
+
+    /**
+     * Enforce timeouts from a watchdog thread that interrupts the script once its deadline passes, so scripts run
+     * without an instruction hook until then. When off (or on platforms without threads) a count hook polls the
+     * clock every HookInterval instructions.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Execution")
+    bool bUseWatchdogTimeouts;
+
+public: // Memory
+    /** Serve small Lua allocations (<= 256 bytes) from per-sandbox size-class slabs instead of the global allocator. */
+    UPROPERTY(EditAnywhere, Config, Category="Memory")
+    bool bUseSmallObjectPool;
+
+    /**
+     * Give one-shot sandboxes (ExecuteString, EvaluateExpression, pooled sandboxes) a single preallocated arena.
+     * Closing them frees the arena in one operation; __gc finalizers of script objects do not run on close.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Memory")
+    bool bUseArenaForOneShotSandboxes;
+
+    /**
+     * Look up common short strings (library and metamethod names, reserved words) in one read-only table shared
+     * by all sandboxes instead of interning a copy in each. Affects sandboxes created afterwards.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Memory")
+    bool bShareInternedStrings;
+
+    /**
+     * Time (microseconds) the runtime subsystem spends each frame running collector steps on its sandboxes,
+     * round-robin, so less collection happens inside script calls. 0 disables frame stepping.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Memory", meta=(ClampMin="0", UIMin="0"))
+    int32 GCStepBudgetMicroseconds;
+
+    /** Work per frame step, as if this many KB had been allocated (0 = one basic Lua step). */
+    UPROPERTY(EditAnywhere, Config, Category="Memory", meta=(ClampMin="0", UIMin="0"))
+    int32 GCStepSizeKB;
+
+    /** Step a sandbox only once its collector is within this many KB of running on its own (or mid-cycle). */
+    UPROPERTY(EditAnywhere, Config, Category="Memory", meta=(ClampMin="0", UIMin="0"))
+    int32 GCStepAheadKB;
+
+public: // Sandbox Pool
+    /** Reuse pre-initialized sandboxes for one-shot execution (ExecuteString, EvaluateExpression, ...). */
+    UPROPERTY(EditAnywhere, Config, Category="Sandbox Pool")
+    bool bEnableSandboxPool;
+
+    /** Maximum number of idle sandboxes kept per memory limit class. */
+    UPROPERTY(EditAnywhere, Config, Category="Sandbox Pool", meta=(ClampMin="0", UIMin="0"))
+    int32 SandboxPoolMaxPerClass;
+
+    /** Memory limit classes (KB) to pre-warm when the subsystem initializes. */
+    UPROPERTY(EditAnywhere, Config, Category="Sandbox Pool")
+    TArray<int32> SandboxPoolPrewarmClassesKB;
+
+    /** Number of sandboxes created up front for each pre-warmed class. */
+    UPROPERTY(EditAnywhere, Config, Category="Sandbox Pool", meta=(ClampMin="0", UIMin="0"))
+    int32 SandboxPoolPrewarmCount;
+
+public: // Chunk Cache
+    /** Cache compiled bytecode of executed sources so repeated runs skip parsing. */
+    UPROPERTY(EditAnywhere, Config, Category="Chunk Cache")
+    bool bEnableChunkCache;
+
+    /** Upper bound (KB) for cached bytecode; least recently used chunks are evicted first. */
+    UPROPERTY(EditAnywhere, Config, Category="Chunk Cache", meta=(ClampMin="0", UIMin="0"))
+    int32 ChunkCacheMaxKB;
+
+public: // Cooking
+    /**
+     * Compile Lua Script assets to bytecode when cooking; the runtime loads it through a trusted path. The Lua
+     * loader does not verify bytecode, so it is signed (HMAC) with the key the module is built with
+     * (LUARUNTIME_BYTECODE_KEY environment variable at build time); without a key scripts are cooked as source only.
+     * The key is compiled into the binary, so a determined attacker can extract it: use signed paks where
+     * tampering matters.
+     */
+    UPROPERTY(EditAnywhere, Config, Category="Cooking")
+    bool bCookScriptBytecode;
+
+    /** Strip line info and local names from cooked bytecode (smaller, but errors lose line numbers). */
+    UPROPERTY(EditAnywhere, Config, Category="Cooking", meta=(EditCondition="bCookScriptBytecode"))
+    bool bStripCookedDebugInfo;
 };
 
@@ -2,15 +2,79 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
 #include "LuaSandbox.h"
+#include "LuaChunkCache.h"
 #include "LuaRuntimeSubsystem.generated.h"
 
+class FLuaSandboxImage;
+class ULuaComponent;
+struct FLuaTickBatch;
+
+USTRUCT(BlueprintType)
+struct FLuaSandboxPoolStats
+{
+    GENERATED_BODY()
+
+    /** Acquisitions served by an idle pooled sandbox. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Hits = 0;
+
+    /** Acquisitions that had to create a new sandbox. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Misses = 0;
+
+    /** Sandboxes reset to their baseline and returned to the pool. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Resets = 0;
+
+    /** Sandboxes closed on release (pool full, disabled, or reset failed). */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 Discards = 0;
+
+    /** Sandboxes currently idle in the pool. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 IdleSandboxes = 0;
+};
+
+/** One row of arguments for EvaluateExpressionBatch. */
+USTRUCT(BlueprintType)
+struct FLuaArgumentSet
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadWrite, Category = "LuaRuntime")
+    TArray<FLuaValue> Args;
+};
+
+USTRUCT()
+struct FLuaSandboxPoolBucket
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<ULuaSandbox*> Idle;
+};
+
 UCLASS()
-class LUARUNTIME_API ULuaRuntimeSubsystem : public UGameInstanceSubsystem
+class LUARUNTIME_API ULuaRuntimeSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
 {
     GENERATED_BODY()
 
 public:
+    // Begin USubsystem
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+    // End USubsystem
+
+    // Begin FTickableGameObject
+    virtual void Tick(float DeltaTime) override;
+    virtual ETickableTickType GetTickableTickType() const override;
+    virtual bool IsTickable() const override;
+    virtual bool IsTickableWhenPaused() const override { return true; }
+    virtual TStatId GetStatId() const override;
+    // End FTickableGameObject
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     ULuaSandbox* CreateSandbox(int32 MemoryLimitKB = 1024);
 
@@ -35,14 +99,104 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Evaluate Expression"))
     FLuaRunResult EvaluateExpression(const FString& Expression, int32 MemoryLimitKB = 1024, int32 TimeoutMs = 50);
 
+    /**
+     * Evaluate one expression against many argument sets in parallel. The expression is compiled once per worker
+     * sandbox as a function of ParamNames (e.g. "base * (1 + crit)" with {"base", "crit"}), and the sets are spread
+     * over up to NumWorkers pooled sandboxes (0 = one per task graph worker). Results come back in input order;
+     * an item that fails only reports its own error.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Batch")
+    TArray<FLuaRunResult> EvaluateExpressionBatch(const FString& Expression, const TArray<FString>& ParamNames, const TArray<FLuaArgumentSet>& ArgumentSets, int32 NumWorkers = 0, int32 MemoryLimitKB = 1024, int32 TimeoutMs = 50);
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void ClearAllSandboxes();
 
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Validate Lua Syntax"))
     bool ValidateLuaSyntax(const FString& Code, FString& OutError) const;
 
+    /** Take a reset sandbox for the given memory limit class from the pool, creating one on a miss. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Pool")
+    ULuaSandbox* AcquireSandbox(int32 MemoryLimitKB = 1024);
+
+    /** Return a sandbox obtained from AcquireSandbox. It is reset to its baseline, or closed if it cannot be reused. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Pool")
+    void ReleaseSandbox(ULuaSandbox* Sandbox);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Pool")
+    FLuaSandboxPoolStats GetSandboxPoolStats() const;
+
+    /** Close every idle pooled sandbox (stats are kept). */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Pool")
+    void TrimSandboxPool();
+
+    /** Snapshot a bootstrapped sandbox as a named golden image. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Images")
+    bool CaptureGoldenImage(const FName ImageName, ULuaSandbox* Source, FString& OutError);
+
+    /** Stamp out a new sandbox from a golden image (no library setup, parsing or bootstrap execution). */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Images")
+    ULuaSandbox* CreateSandboxFromImage(const FName ImageName, int32 MemoryLimitKB = 1024);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Images")
+    bool RemoveGoldenImage(const FName ImageName);
+
+    TSharedPtr<const FLuaSandboxImage> GetGoldenImage(const FName ImageName) const;
+
+    /** Hit rate and memory footprint of the process-wide compiled chunk cache. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Cache")
+    FLuaChunkCacheStats GetChunkCacheStats() const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Cache")
+    void ClearChunkCache();
+
+    /** Memory telemetry summed over every live sandbox (named, pooled and user-created); lock-free per sandbox. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Memory")
+    FLuaMemoryStats GetTotalMemoryStats() const;
+
+    /**
+     * Microseconds per frame spent on collector steps across sandboxes created through this subsystem (plus any
+     * added with AddGCSteppedSandbox), round-robin. 0 disables; defaults to the project setting.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Memory")
+    void SetGCStepBudget(int32 Microseconds);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|Memory")
+    int32 GetGCStepBudget() const { return GCStepBudgetUs; }
+
+    /** Include a sandbox created elsewhere in frame GC stepping (held weakly). */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Memory")
+    void AddGCSteppedSandbox(ULuaSandbox* Sandbox);
+
+    /**
+     * Add a component to the batched tick of its sandbox, tick group and LuaTickFunction (re-registering it if it
+     * was already in one). Called by ULuaComponent::SetLuaTickEnabled.
+     */
+    void RegisterLuaTick(ULuaComponent* Component);
+    void UnregisterLuaTick(ULuaComponent* Component);
+
+private:
+    ULuaSandbox* CreateOneShotSandbox(int32 MemoryLimitKB);
+    ULuaSandbox* CreatePooledSandbox(int32 MemoryLimitKB);
+
 private:
     UPROPERTY()
     TMap<FName, ULuaSandbox*> NamedSandboxes;
+
+    /** Idle pre-initialized sandboxes keyed by memory limit (KB). */
+    UPROPERTY()
+    TMap<int32, FLuaSandboxPoolBucket> SandboxPool;
+
+    FLuaSandboxPoolStats PoolStats;
+
+    TMap<FName, TSharedPtr<const FLuaSandboxImage>> GoldenImages;
+
+    /** Sandboxes visited by frame GC stepping; GCCursor is where the next frame starts. */
+    TArray<TWeakObjectPtr<ULuaSandbox>> GCSandboxes;
+    int32 GCCursor = 0;
+    int32 GCStepBudgetUs = 0;
+
+    /** Engine tick functions doing batched component ticks (shared so components can refer to theirs weakly). */
+    TArray<TSharedPtr<FLuaTickBatch>> TickBatches;
+    int32 LastLuaTickId = 0;
 };
 
@@ -2,10 +2,15 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Tasks/Pipe.h"
 #include "LuaValue.h"
+#include <atomic>
 #include "LuaSandbox.generated.h"
 
 struct lua_State;
+class FLuaSandboxImage;
+class ULuaTableRef;
+struct FLuaMemoryCounters;
 
 USTRUCT(BlueprintType)
 struct FLuaRunResult
@@ -40,6 +45,206 @@ struct FLuaValue
     bool bIsNil = true;
 };
 
+USTRUCT(BlueprintType)
+struct FLuaSizeClassStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 BlockSize = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 NumSlabs = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 BlocksInUse = 0;
+
+    /** Carved or uncarved blocks available in this class's slabs. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 BlocksFree = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 TotalAllocations = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FLuaAllocatorStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    bool bSmallObjectPool = false;
+
+    /** Bytes currently requested by Lua (what the memory limit applies to). */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 UsedBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 LimitBytes = 0;
+
+    /** Bytes Lua requested for small objects, before size-class rounding. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 SmallRequestedBytes = 0;
+
+    /** Bytes of small blocks in use, after rounding. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 SmallBlockBytes = 0;
+
+    /** Bytes reserved by slabs. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 SlabBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 LargeBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 NumLargeBlocks = 0;
+
+    /** True when the heap lives in a single preallocated arena. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    bool bArena = false;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 ArenaBytes = 0;
+
+    /** High-water mark of the arena bump pointer. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 ArenaTopBytes = 0;
+
+    /** Share of reserved memory (slabs, or the used part of the arena) lost to rounding, free blocks and headers. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    float Fragmentation = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    TArray<FLuaSizeClassStats> SizeClasses;
+};
+
+/** Memory telemetry of a sandbox, or the sum over all live sandboxes (see ULuaSandbox::GetTotalMemoryStats). */
+USTRUCT(BlueprintType)
+struct FLuaMemoryStats
+{
+    GENERATED_BODY()
+
+    /** Bytes currently requested by Lua. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 UsedBytes = 0;
+
+    /** High-water mark of UsedBytes since the state was created (sum of the peaks for totals). */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 PeakBytes = 0;
+
+    /** 0 means unlimited. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 LimitBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 NumAllocations = 0;
+
+    /** Requests refused by the memory limit or the allocator; Lua retries once after an emergency collection. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 NumFailedAllocations = 0;
+
+    /** Collector debt as of the last call; positive means a collection step is due. */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int64 GCDebtBytes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    int32 NumSandboxes = 0;
+};
+
+/**
+ * Handle to a Lua function held in the sandbox registry (luaL_ref).
+ * Resolve once with ULuaSandbox::ResolveFunction and call repeatedly without a global lookup.
+ * Handles become invalid when the sandbox is closed, re-initialized or reset to its baseline.
+ */
+USTRUCT(BlueprintType)
+struct FLuaFunctionRef
+{
+    GENERATED_BODY()
+
+    /** Name the handle was resolved from (diagnostics only). */
+    UPROPERTY(BlueprintReadOnly, Category = "LuaRuntime")
+    FString Name;
+
+private:
+    friend class ULuaSandbox;
+
+    int32 Ref = -2; // LUA_NOREF
+    uint32 StateGeneration = 0;
+};
+
+/** Registry handle to the Lua table that stands for one actor in batched ticks (see ULuaSandbox::CallTickBatch). */
+struct FLuaTickEntryRef
+{
+private:
+    friend class ULuaSandbox;
+
+    int32 Ref = -2; // LUA_NOREF
+    uint32 StateGeneration = 0;
+};
+
+UENUM(BlueprintType)
+enum class ELuaGCMode : uint8
+{
+    /** Interleaves mark and sweep steps with allocation; bounded pauses, the Lua default. */
+    Incremental,
+    /** Collects young objects frequently and cheaply; suits scripts that churn short-lived tables. */
+    Generational
+};
+
+UENUM(BlueprintType)
+enum class ELuaTaskStatus : uint8
+{
+    /** Unknown, already collected, or the sandbox was closed/reset. */
+    Invalid,
+    /** Paused at the end of a slice; call ResumeTask again (typically next frame). */
+    Running,
+    Completed,
+    Failed
+};
+
+/**
+ * Handle to a time-sliced task started with RunStringSliced / CallFunctionSliced.
+ * Becomes invalid once ResumeTask has reported its final status, or when the sandbox is closed or reset.
+ */
+USTRUCT(BlueprintType)
+struct FLuaTaskHandle
+{
+    GENERATED_BODY()
+
+private:
+    friend class ULuaSandbox;
+
+    int32 Id = 0;
+    uint32 StateGeneration = 0;
+};
+
+/** Owner of a native function bound with ULuaSandbox::Bind (see LuaBinding.h). */
+struct FLuaNativeBinding
+{
+    virtual ~FLuaNativeBinding() = default;
+};
+
+/** Element type of a typed buffer (the Lua `buffer` library). */
+enum class ELuaBufferType : uint8
+{
+    Float,
+    Double,
+    Int32
+};
+
+template <typename T>
+struct TLuaBufferType
+{
+    static_assert(sizeof(T) == 0, "Lua buffers hold float, double or int32 elements");
+};
+template <> struct TLuaBufferType<float> { static constexpr ELuaBufferType Value = ELuaBufferType::Float; };
+template <> struct TLuaBufferType<double> { static constexpr ELuaBufferType Value = ELuaBufferType::Double; };
+template <> struct TLuaBufferType<int32> { static constexpr ELuaBufferType Value = ELuaBufferType::Int32; };
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnLuaAsyncComplete, const FLuaRunResult&, Result);
+DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam(FLuaValue, FLuaCallbackDelegate, const TArray<FLuaValue>&, Args);
+
 UCLASS(BlueprintType)
 class LUARUNTIME_API ULuaSandbox : public UObject
 {
@@ -52,9 +257,30 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void Initialize(int32 MemoryLimitKB = 1024);
 
+    /**
+     * Initialize with the whole Lua heap in one preallocated arena sized from MemoryLimitKB.
+     * Meant for short-lived sandboxes: Close() releases the arena in one operation instead of freeing each
+     * object, which also means __gc finalizers do not run on close.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void InitializeArena(int32 MemoryLimitKB = 1024);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    bool IsArena() const { return bArena; }
+
+    /** Initialize from a captured image instead of opening libraries and running bootstrap code. */
+    bool InitializeFromImage(const TSharedPtr<const FLuaSandboxImage>& Image, int32 MemoryLimitKB, FString& OutError);
+
+    /** Capture this sandbox's globals as an immutable image that new sandboxes can be stamped from. */
+    TSharedPtr<const FLuaSandboxImage> CaptureImage(FString& OutError) const;
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     FLuaRunResult RunString(const FString& Code, int32 TimeoutMs = 50, int32 HookInterval = 1000);
 
+    /** Run a script asset, using its cooked bytecode when present and falling back to the source text. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    FLuaRunResult RunScript(const class ULuaScript* Script, int32 TimeoutMs = 50, int32 HookInterval = 1000);
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void SetGlobalNumber(const FName Name, double Value);
 
@@ -70,6 +296,20 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void Close();
 
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    bool IsInitialized() const { return L != nullptr; }
+
+    /** Snapshot the globals table and the tables directly reachable from it so RestoreBaseline can undo script changes. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool SaveBaseline();
+
+    /**
+     * Restore globals (and first-level tables such as string/math) to the last saved baseline and run a full GC.
+     * Instruction budgets and collector settings go back to the defaults; functions added with Bind are removed.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool RestoreBaseline();
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void SetGlobalBool(const FName Name, bool Value);
 
@@ -82,12 +322,82 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     bool GetGlobalDyn(const FName Name, FLuaDynValue& OutValue) const;
 
+    /** Flat (UObject-free) counterparts of the Dyn accessors; prefer these for large tables. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void SetGlobalFlat(const FName Name, const FLuaFlatValue& Value);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool GetGlobalFlat(const FName Name, FLuaFlatValue& OutValue) const;
+
+    /**
+     * Typed buffers: contiguous float/double/int32 arrays that scripts use through the `buffer` library.
+     * The returned views point into the Lua heap (no copy) and stay valid while the buffer is reachable from Lua
+     * and the sandbox is open. Empty on failure: no state, memory limit, or a global that is not a buffer of T.
+     */
+    template <typename T>
+    TArrayView<T> CreateGlobalBuffer(const FName Name, int32 Num);
+
+    template <typename T>
+    TArrayView<T> GetGlobalBuffer(const FName Name) const;
+
+    /** Copy Values into a new buffer global in one block. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool SetGlobalFloatBuffer(const FName Name, const TArray<float>& Values);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool SetGlobalDoubleBuffer(const FName Name, const TArray<double>& Values);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool SetGlobalIntBuffer(const FName Name, const TArray<int32>& Values);
+
+    /** Copy a buffer global out in one block; false unless it is a buffer of that element type. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool GetGlobalFloatBuffer(const FName Name, TArray<float>& OutValues) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool GetGlobalDoubleBuffer(const FName Name, TArray<double>& OutValues) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Buffers")
+    bool GetGlobalIntBuffer(const FName Name, TArray<int32>& OutValues) const;
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Call Lua Function"))
     FLuaRunResult CallFunction(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 TimeoutMs = 50);
 
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta=(DisplayName="Call Lua Function (Dyn)") )
     FLuaRunResult CallFunctionDyn(const FString& FunctionName, const TArray<FLuaDynValue>& Args, int32 TimeoutMs = 50);
 
+    /** Look up a global function (or dotted path like "AI.Tick") once and keep a registry handle to it. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool ResolveFunction(const FString& FunctionName, FLuaFunctionRef& OutFunction);
+
+    /** Run Code, which must return a function (e.g. "return function(x) return x * 2 end"), and keep a handle to it. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool LoadFunction(const FString& Code, FLuaFunctionRef& OutFunction, FString& OutError, int32 TimeoutMs = 50);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    bool IsFunctionValid(const FLuaFunctionRef& Function) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void ReleaseFunction(UPARAM(ref) FLuaFunctionRef& Function);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Call Lua Function (Handle)"))
+    FLuaRunResult CallFunctionRef(const FLuaFunctionRef& Function, const TArray<FLuaValue>& Args, int32 TimeoutMs = 50);
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Call Lua Function (Handle, Dyn)"))
+    FLuaRunResult CallFunctionRefDyn(const FLuaFunctionRef& Function, const TArray<FLuaDynValue>& Args, int32 TimeoutMs = 50);
+
+    /** Create the table { id = Id, name = Name } that stands for one actor in CallTickBatch; scripts may keep state in it. */
+    bool CreateTickEntry(int32 Id, const FString& Name, FLuaTickEntryRef& OutEntry);
+    bool IsTickEntryValid(const FLuaTickEntryRef& Entry) const;
+    void ReleaseTickEntry(FLuaTickEntryRef& Entry);
+
+    /**
+     * Call Function(DeltaTime, actors) once for a whole batch. actors is an array of the entry tables, each with its
+     * dt field set to the matching EntryDeltaTimes element (time since that actor last ticked). Invalid entries are
+     * left out.
+     */
+    FLuaRunResult CallTickBatch(const FLuaFunctionRef& Function, float DeltaTime, TConstArrayView<FLuaTickEntryRef> Entries, TConstArrayView<float> EntryDeltaTimes, int32 TimeoutMs = 50);
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     bool HasGlobal(const FName Name) const;
 
@@ -109,46 +419,298 @@ public:
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Get Table Value (Dyn)"))
     bool GetTableValueDyn(const FString& TablePath, const FString& Key, FLuaDynValue& OutValue) const;
 
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Get Table Value (Flat)"))
+    bool GetTableValueFlat(const FString& TablePath, const FString& Key, FLuaFlatValue& OutValue) const;
+
+    /** Reference a live table by path (e.g. "world.players") without copying it; fields are read on demand. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    ULuaTableRef* GetTableRef(const FString& TablePath);
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     FLuaRunResult RunFile(const FString& FilePath, int32 TimeoutMs = 50, int32 HookInterval = 1000);
 
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     bool RunStringDyn(const FString& Code, int32 TimeoutMs, int32 HookInterval, FLuaDynValue& OutValue, FString& OutError);
 
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    bool RunStringFlat(const FString& Code, int32 TimeoutMs, int32 HookInterval, FLuaFlatValue& OutValue, FString& OutError);
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     bool RunFileDyn(const FString& FilePath, int32 TimeoutMs, int32 HookInterval, FLuaDynValue& OutValue, FString& OutError);
 
+    /**
+     * Expose a native function or lambda to Lua as global Name, with argument marshaling generated from its
+     * signature. Defined in LuaBinding.h; include it to use. A binding lives until the sandbox is closed, the name is
+     * bound again or RestoreBaseline runs; closures scripts kept from it then raise an error instead of calling it.
+     */
+    template <typename FuncType>
+    bool Bind(const FString& Name, FuncType&& Func);
+
+    /** Define a global Lua function CallbackName that fires OnLuaCallback with its name and arguments. */
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Register Blueprint Callback"))
     void RegisterCallback(const FString& CallbackName);
 
+    /** Like RegisterCallback, but the Lua function also calls Callback and returns its value to the script. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Register Blueprint Callback (Return Value)"))
+    void RegisterCallbackWithReturn(const FString& CallbackName, FLuaCallbackDelegate Callback);
+
+    /** Forget all callback registrations; calling one from Lua afterwards raises an error. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void ClearCallbacks();
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     int64 GetMemoryUsage() const;
 
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
     void SetMemoryLimit(int32 NewLimitKB);
 
+    /** Allocator breakdown: size-class usage, slab reservation and fragmentation. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    FLuaAllocatorStats GetAllocatorStats() const;
+
+    /**
+     * Usage, peak, limit, allocation counts and GC debt. Lock-free and safe from any thread, also while the sandbox
+     * runs async work; values are at most one allocation stale.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    FLuaMemoryStats GetMemoryStats() const;
+
+    /** Sum of GetMemoryStats over every live sandbox in the process. */
+    static FLuaMemoryStats GetTotalMemoryStats();
+
+    /**
+     * Use the incremental collector. Pause (%) is how far memory grows before a cycle starts (Lua default 200),
+     * StepMul (%) how much work each step does relative to allocation (100) and StepSizeLog2 the allocation between
+     * steps (13, i.e. 8 KB). 0 keeps the current value. Kept across Close/Initialize; RestoreBaseline resets it.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|GC")
+    void SetIncrementalGC(int32 Pause = 0, int32 StepMul = 0, int32 StepSizeLog2 = 0);
+
+    /**
+     * Use the generational collector. MinorMul (%) is the growth that triggers a minor collection (Lua default 20),
+     * MajorMul (%) the growth that triggers a major one (100). 0 keeps the current value. Kept across Close/Initialize;
+     * RestoreBaseline resets it.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|GC")
+    void SetGenerationalGC(int32 MinorMul = 0, int32 MajorMul = 0);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|GC")
+    ELuaGCMode GetGCMode() const { return GCMode; }
+
+    /**
+     * Do collector work now instead of inside a later call: StepKB 0 runs one basic step, otherwise the collector
+     * works as if StepKB had been allocated. Returns true when the step finished a cycle.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|GC")
+    bool StepGC(int32 StepKB = 0);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    int32 GetMemoryLimitKB() const { return (int32)(AllocLimitBytes / 1024); }
+
+    /**
+     * Limit every call (RunString, CallFunction, EvaluateExpression, ...) to PerCall VM instructions; a script going
+     * over fails with "instruction budget exceeded". Unlike TimeoutMs this does not depend on machine load.
+     * 0 means unlimited, -1 uses the project default.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void SetInstructionBudget(int64 PerCall);
+
+    /** Limit the VM instructions all calls on this sandbox may run within one engine frame. 0 unlimited, -1 project default. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime")
+    void SetFrameInstructionBudget(int64 PerFrame);
+
+    /** Instructions the last call had left of its budget, or -1 if it ran without one. */
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    int64 GetRemainingInstructionBudget() const { return LastCallBudgetLeft; }
+
+    /** Instructions left in this frame's budget, or -1 if there is no frame budget. */
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime")
+    int64 GetRemainingFrameInstructionBudget() const;
+
+    /**
+     * Run code as a resumable task. It executes in a coroutine for at most SliceMs (and within the instruction
+     * budgets), then yields instead of failing, and continues from there on the next ResumeTask call. Scripts
+     * may also call coroutine.yield() to wait for the next slice. The first slice runs immediately.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Tasks")
+    FLuaTaskHandle RunStringSliced(const FString& Code, int32 SliceMs = 2, int32 HookInterval = 1000);
+
+    /** Call a global function as a resumable task; see RunStringSliced. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Tasks", meta = (DisplayName = "Call Lua Function (Sliced)"))
+    FLuaTaskHandle CallFunctionSliced(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 SliceMs = 2);
+
+    /** Run the next slice of a task. Once it returns Completed or Failed, OutResult holds the outcome and the handle is spent. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Tasks")
+    ELuaTaskStatus ResumeTask(const FLuaTaskHandle& Task, FLuaRunResult& OutResult);
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|Tasks")
+    ELuaTaskStatus GetTaskStatus(const FLuaTaskHandle& Task) const;
+
+    /** Drop a task without running it further. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Tasks")
+    void CancelTask(const FLuaTaskHandle& Task);
+
+    /**
+     * Run code on a task graph worker; OnComplete fires on the game thread. Work queued on one sandbox runs in
+     * order, one item at a time, while different sandboxes run in parallel. Until all queued work has finished
+     * (IsBusy) the sandbox refuses every other call, and scripts cannot invoke Blueprint callbacks.
+     */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Async")
+    void RunStringAsync(const FString& Code, FOnLuaAsyncComplete OnComplete, int32 TimeoutMs = 50, int32 HookInterval = 1000);
+
+    /** Call a global function on a task graph worker; see RunStringAsync. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Async", meta = (DisplayName = "Call Lua Function (Async)"))
+    void CallFunctionAsync(const FString& FunctionName, const TArray<FLuaValue>& Args, FOnLuaAsyncComplete OnComplete, int32 TimeoutMs = 50);
+
+    /** C++ counterparts of RunStringAsync/CallFunctionAsync; the returned task completes on the worker. */
+    UE::Tasks::TTask<FLuaRunResult> LaunchRunString(const FString& Code, int32 TimeoutMs = 50, int32 HookInterval = 1000);
+    UE::Tasks::TTask<FLuaRunResult> LaunchCallFunction(const FString& FunctionName, const TArray<FLuaValue>& Args, int32 TimeoutMs = 50);
+
+    /** True while async work is queued or running on this sandbox. */
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|Async")
+    bool IsBusy() const { return AsyncInFlight.load() > 0; }
+
+    /** Block until all async work queued on this sandbox has run. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Async")
+    void WaitForAsync();
+
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Evaluate Expression"))
     FLuaRunResult EvaluateExpression(const FString& Expression, int32 TimeoutMs = 50);
 
     UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Evaluate Expression (Dyn)"))
     bool EvaluateExpressionDyn(const FString& Expression, int32 TimeoutMs, FLuaDynValue& OutValue, FString& OutError);
 
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime", meta = (DisplayName = "Evaluate Expression (Flat)"))
+    bool EvaluateExpressionFlat(const FString& Expression, int32 TimeoutMs, FLuaFlatValue& OutValue, FString& OutError);
+
     DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLuaCallback, const FString&, CallbackName, const TArray<FLuaValue>&, Args);
     UPROPERTY(BlueprintAssignable, Category = "LuaRuntime")
     FOnLuaCallback OnLuaCallback;
 
 private:
-    void* CreateState(int32 MemoryLimitKB);
+    void* CreateState(int32 MemoryLimitKB, bool bUseArena = false);
+    void ApplyGCMode(lua_State* State) const;
+    struct FLuaTaskState
+    {
+        int32 ThreadRef = -2; // LUA_NOREF
+        int32 NumArgs = 0;
+        int32 SliceMs = 0;
+        int32 HookInterval = 0;
+        ELuaTaskStatus Status = ELuaTaskStatus::Running;
+        FLuaRunResult Result;
+    };
+
+    /** lua_pcall under the call's timeout and instruction budget. */
+    int ProtectedCall(int NumArgs, int NumResults, int32 TimeoutMs, int32 HookInterval);
+    /** Run Body with the timeout and budget hooks armed; with a SliceThread they yield it instead of failing. */
+    int RunHooked(int32 TimeoutMs, int32 HookInterval, lua_State* SliceThread, TFunctionRef<int()> Body);
+    /** Start a task from the function and NumArgs arguments on top of the stack and run its first slice. */
+    FLuaTaskHandle StartTask(int32 NumArgs, int32 SliceMs, int32 HookInterval);
+    /** A task that failed before it could start (load error, missing function); ResumeTask reports the error. */
+    FLuaTaskHandle AddFailedTask(const FString& Error);
+    void RunTaskSlice(int32 TaskId);
+    bool IsTaskHandleCurrent(const FLuaTaskHandle& Handle) const;
+    /** The state exists and this thread may use it (no async work in flight, or we are that work). */
+    bool IsStateAvailable(FString* OutError = nullptr) const;
+    bool BindNative(const FString& Name, TUniquePtr<FLuaNativeBinding>&& Binding, int (*Thunk)(lua_State*));
+    /** Free every Bind functor after detaching it from the closures scripts may still hold. */
+    void ClearNativeBindings();
+    bool CreateGlobalBufferRaw(const FName Name, ELuaBufferType Type, int32 Num, void*& OutData);
+    void* GetGlobalBufferRaw(const FName Name, ELuaBufferType Type, int32& OutNum) const;
+    template <typename T>
+    bool CopyToGlobalBuffer(const FName Name, const TArray<T>& Values);
+    template <typename T>
+    bool CopyFromGlobalBuffer(const FName Name, TArray<T>& OutValues) const;
+    /** C closure behind registered callbacks; upvalues hold the sandbox and the callback id. */
+    static int CallbackTrampoline(lua_State* State);
+    /** Runs the callback and stores its result; returns the number of results (0 or 1), or -1 if the id is unknown. */
+    int DispatchCallback(lua_State* State, int32 CallbackId);
+    /** Push the result stored by DispatchCallback. */
+    void PushCallbackResult(lua_State* State) const;
+    UE::Tasks::TTask<FLuaRunResult> LaunchAsync(const TCHAR* DebugName, TUniqueFunction<FLuaRunResult()>&& Work, FOnLuaAsyncComplete OnComplete);
+    FLuaRunResult RunLoadedChunk(int32 TimeoutMs, int32 HookInterval);
+    bool PushFunctionRef(const FLuaFunctionRef& Function, FLuaRunResult& OutResult);
+    FLuaRunResult CallPushedFunction(int32 NumArgs, int32 TimeoutMs);
+    bool RunStringSingleResult(const FString& Code, int32 TimeoutMs, int32 HookInterval, FString& OutError);
     void OpenSafeLibs();
     void InstallPrint();
     void RemoveUnsafeBaseFuncs();
     void PushLuaValue(const FLuaValue& Value);
     void PushLuaDynValue(const FLuaDynValue& Value);
+    void PushLuaFlatValue(const FLuaFlatValue& Value, int32 NodeIndex);
     FLuaValue PopLuaValue() const;
-    FLuaDynValue PopLuaDynValue() const;
+    FLuaDynValue PopLuaDynValue(int32 MaxDepth = 32) const;
+    FString ReadLuaKey(int Index) const;
     bool GetTableByPath(const FString& TablePath) const;
 
 private:
+    friend class ULuaTableRef;
+
     lua_State* L = nullptr;
     int64 AllocLimitBytes = 0;
+    bool bArena = false;
+
+    /** Bumped whenever registry handles become stale (Close, RestoreBaseline). */
+    uint32 StateGeneration = 1;
+
+    /** Configured budgets; -1 defers to ULuaRuntimeSettings. */
+    int64 InstructionBudget = INDEX_NONE;
+    int64 FrameInstructionBudget = INDEX_NONE;
+    int64 FrameInstructionsUsed = 0;
+    uint64 FrameInstructionsFrame = 0;
+    int64 LastCallBudgetLeft = INDEX_NONE;
+    int32 CallDepth = 0;
+
+    TMap<int32, FLuaTaskState> Tasks;
+    int32 LastTaskId = 0;
+
+    struct FLuaCallbackEntry
+    {
+        FString Name;
+        FLuaCallbackDelegate Callback;
+    };
+    TMap<int32, FLuaCallbackEntry> Callbacks;
+    int32 LastCallbackId = 0;
+    /** Argument array reused across callback calls. */
+    TArray<FLuaValue> CallbackArgs;
+    /**
+     * Result of the last callback, kept here so the trampoline can push it after every C++ temporary is gone.
+     * A string is stored as UTF-8 in CallbackResultUtf8; CallbackResult.StringValue stays empty.
+     */
+    FLuaValue CallbackResult;
+    TArray<ANSICHAR> CallbackResultUtf8;
+    bool bCallbackResultIsString = false;
+
+    /** Collector settings; params mean Pause/StepMul/StepSizeLog2 or MinorMul/MajorMul depending on the mode. */
+    ELuaGCMode GCMode = ELuaGCMode::Incremental;
+    int32 GCParams[3] = { 0, 0, 0 };
+    /** Set once SetIncrementalGC/SetGenerationalGC changed the state's parameters; RestoreBaseline undoes them. */
+    bool bGCConfigured = false;
+
+    /** Telemetry written by the allocator; shared with the process-wide registry behind GetTotalMemoryStats. */
+    TSharedPtr<FLuaMemoryCounters, ESPMode::ThreadSafe> MemoryCounters;
+
+    /** Functors behind Bind by global name; the closures reference them as light userdata. */
+    TMap<FString, TUniquePtr<FLuaNativeBinding>> NativeBindings;
+
+    /** Serializes async work on this sandbox. */
+    UE::Tasks::FPipe AsyncPipe{ TEXT("LuaSandbox") };
+    std::atomic<int32> AsyncInFlight{0};
+    /** Thread running the current async item, 0 between items. */
+    std::atomic<uint32> AsyncThreadId{0};
 };
+
+template <typename T>
+TArrayView<T> ULuaSandbox::CreateGlobalBuffer(const FName Name, int32 Num)
+{
+    void* Data = nullptr;
+    return CreateGlobalBufferRaw(Name, TLuaBufferType<T>::Value, Num, Data) ? TArrayView<T>(static_cast<T*>(Data), Num) : TArrayView<T>();
+}
+
+template <typename T>
+TArrayView<T> ULuaSandbox::GetGlobalBuffer(const FName Name) const
+{
+    int32 Num = 0;
+    T* Data = static_cast<T*>(GetGlobalBufferRaw(Name, TLuaBufferType<T>::Value, Num));
+    return Data ? TArrayView<T>(Data, Num) : TArrayView<T>();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct lua_State;
+
+/**
+ * FLuaSandboxImage is an immutable snapshot of a bootstrapped sandbox's globals.
+ * Tables, strings and functions reachable from _G (and the string, vector and buffer metatables) are stored as a flat node graph;
+ * Lua functions are kept as bytecode produced by our own compiler, so stamping out a new sandbox
+ * rebuilds the heap without parsing or re-running the bootstrap script.
+ * Userdata, threads and light userdata are not captured (they become nil), and neither are C functions holding one
+ * as an upvalue, such as coroutine.wrap functions and string.gmatch iterators.
+ */
+class LUARUNTIME_API FLuaSandboxImage
+{
+public:
+    /** Capture the globals of L. Returns null and sets OutError on failure. */
+    static TSharedPtr<const FLuaSandboxImage> Capture(lua_State* L, FString& OutError);
+
+    /** Rebuild the captured globals inside a freshly created state (no libraries opened). */
+    bool Instantiate(lua_State* L, FString& OutError) const;
+
+    int32 GetNumNodes() const { return Nodes.Num(); }
+    int32 GetNumSkippedValues() const { return NumSkippedValues; }
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    using FCFunction = int (*)(lua_State*);
+
+    enum class ENodeKind : uint8
+    {
+        Boolean,
+        Integer,
+        Number,
+        Vector,
+        String,
+        Table,
+        LuaFunction,
+        CFunction
+    };
+
+    struct FNode
+    {
+        ENodeKind Kind = ENodeKind::Boolean;
+        bool Boolean = false;
+        int64 Integer = 0;
+        double Number = 0.0;
+        FVector Vector = FVector::ZeroVector;
+        FCFunction CFunction = nullptr;
+
+        /** String bytes or function bytecode. */
+        TArray<uint8> Bytes;
+
+        /** Tables: flattened key/value node pairs. Functions: upvalue nodes (INDEX_NONE = nil). */
+        TArray<int32> Children;
+
+        /** Lua functions: identity of each upvalue cell so shared upvalues stay shared (INDEX_NONE = not shared). */
+        TArray<int32> UpvalueIds;
+
+        int32 Metatable = INDEX_NONE;
+    };
+
+    friend struct FLuaImageCapture;
+    friend struct FLuaImageInstantiate;
+
+    /** Node 0 is always the globals table. */
+    TArray<FNode> Nodes;
+    int32 StringMetatable = INDEX_NONE;
+    int32 VectorMetatable = INDEX_NONE;
+    int32 BufferMetatable = INDEX_NONE;
+    int32 NumUpvalueIds = 0;
+    int32 NumSkippedValues = 0;
+};
@@ -4,6 +4,8 @@
 #include "UObject/Object.h"
 #include "LuaScript.generated.h"
 
+class FObjectPreSaveContext;
+
 /**
  * ULuaScript stores Lua source code as a content asset.
  * Includes simple syntax validation (editor only) and helper accessors.
@@ -24,9 +26,28 @@ public:
     UFUNCTION(BlueprintPure, Category="Lua")
     const FString& GetSource() const { return Source; }
 
-    // Replace the source text.
+    // Replace the source text (drops any cooked bytecode, which no longer matches).
     UFUNCTION(BlueprintCallable, Category="Lua")
-    void SetSource(const FString& InSource) { Source = InSource; }
+    void SetSource(const FString& InSource) { Source = InSource; ClearBytecode(); }
+
+    // Compile Source into bytecode stored on the asset. Done automatically when cooking.
+    bool CompileBytecode(bool bStripDebugInfo, FString& OutError);
+
+    // Drop compiled bytecode so the runtime compiles from Source.
+    void ClearBytecode();
+
+    // True when compiled bytecode is present, carries a valid signature and was built from the current Source.
+    // Always false in builds without a bytecode key (LUARUNTIME_BYTECODE_KEY), so they compile from Source.
+    bool HasValidBytecode() const;
+
+    // Chunk name for both the bytecode and the source path, so errors name the script the same way.
+    static constexpr const char* ChunkName = "chunk";
+
+    const TArray<uint8>& GetCompiledBytecode() const { return CompiledBytecode; }
+
+    // Begin UObject
+    virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+    // End UObject
 
 public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua", meta=(MultiLine=true))
@@ -36,6 +57,20 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua")
     bool bTreatAsModule = false;
 
+private:
+    // Bytecode compiled from Source at cook time; only loaded through ULuaSandbox::RunScript.
+    UPROPERTY()
+    TArray<uint8> CompiledBytecode;
+
+    // HMAC-SHA1 of CompiledBytecode and CompiledSourceHash under the build's bytecode key. lundump does not verify
+    // bytecode, so only a blob signed by a build holding the key is ever loaded.
+    UPROPERTY()
+    TArray<uint8> CompiledBytecodeSignature;
+
+    // CityHash64 of the UTF-8 Source the bytecode was compiled from; a different Source falls back to compiling it.
+    UPROPERTY()
+    uint64 CompiledSourceHash = 0;
+
 protected:
 #if WITH_EDITOR
     virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
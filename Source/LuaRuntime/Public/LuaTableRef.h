@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "LuaValue.h"
+#include "LuaTableRef.generated.h"
+
+class ULuaSandbox;
+
+/**
+ * ULuaTableRef keeps a registry reference to a live Lua table and reads it on demand.
+ * Unlike the Dyn/Flat getters nothing is copied up front, so reading one field of a huge table costs one lookup.
+ * Access is raw (metamethods are not invoked), which keeps reads from running script code outside a timeout.
+ * A reference becomes invalid when its sandbox is closed, re-initialized or reset to its baseline.
+ */
+UCLASS(BlueprintType)
+class LUARUNTIME_API ULuaTableRef : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    virtual void BeginDestroy() override;
+
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|Table")
+    bool IsValid() const;
+
+    /** Border of the array part (the # operator without __len). */
+    UFUNCTION(BlueprintPure, Category = "LuaRuntime|Table")
+    int32 Length() const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    TArray<FString> GetKeys() const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool HasField(const FString& Key) const;
+
+    /** Read a field; nested tables are deep-copied into the Dyn value (use GetFieldTable to stay lazy). */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetField(const FString& Key, FLuaDynValue& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetFieldNumber(const FString& Key, double& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetFieldString(const FString& Key, FString& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetFieldBool(const FString& Key, bool& OutValue) const;
+
+    /** Reference to a nested table field, or null when the field is not a table. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    ULuaTableRef* GetFieldTable(const FString& Key) const;
+
+    /** Read array element Index (1-based, as in Lua). */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetIndex(int32 Index, FLuaDynValue& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    ULuaTableRef* GetIndexTable(int32 Index) const;
+
+    /** Follow a dotted field path such as "stats.health" from this table. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetPath(const FString& Path, FLuaDynValue& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool GetPathNumber(const FString& Path, double& OutValue) const;
+
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    bool SetField(const FString& Key, const FLuaDynValue& Value);
+
+    /** Drop the registry reference now instead of waiting for garbage collection. */
+    UFUNCTION(BlueprintCallable, Category = "LuaRuntime|Table")
+    void Release();
+
+    /**
+     * Visit every key/value pair. Nested tables are passed as empty Table values (use GetFieldTable to descend).
+     * Return false from the visitor to stop early.
+     */
+    void ForEachPair(TFunctionRef<bool(const FString& Key, const FLuaDynValue& Value)> Visitor) const;
+
+private:
+    friend class ULuaSandbox;
+
+    /** Wrap the table on top of the sandbox stack (popped either way); null if it is not a table. */
+    static ULuaTableRef* CreateFromTop(ULuaSandbox* Owner);
+
+    /** Push the referenced table on the sandbox stack. Returns null (and pushes nothing) when invalid. */
+    ULuaSandbox* PushTable() const;
+
+    /** Push the value at a dotted path; false (nothing pushed) when an intermediate value is not a table. */
+    ULuaSandbox* PushPath(const FString& Path) const;
+
+    TWeakObjectPtr<ULuaSandbox> Sandbox;
+    int32 Ref = -2; // LUA_NOREF
+    uint32 StateGeneration = 0;
+};
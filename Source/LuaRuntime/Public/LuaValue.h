@@ -14,7 +14,8 @@ enum class ELuaType : uint8
     Number   UMETA(DisplayName="Number"),
     String   UMETA(DisplayName="String"),
     Array    UMETA(DisplayName="Array"),
-    Table    UMETA(DisplayName="Table")
+    Table    UMETA(DisplayName="Table"),
+    Vector   UMETA(DisplayName="Vector")
 };
 
 USTRUCT(BlueprintType)
@@ -34,6 +35,10 @@ struct FLuaDynValue
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua", meta=(EditCondition="Type==ELuaType::Boolean"))
     bool Boolean = false;
 
+    /** Lua vector value (the built-in vector type; tables with x/y/z fields stay Table). */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua", meta=(EditCondition="Type==ELuaType::Vector"))
+    FVector Vector = FVector::ZeroVector;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua", meta=(EditCondition="Type==ELuaType::Array"))
     TArray<TObjectPtr<ULuaValueObject>> Array;
 
@@ -49,3 +54,72 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Lua")
     FLuaDynValue Value;
 };
+
+/**
+ * One node of an FLuaFlatValue. Container children are stored contiguously in the owning value's node array,
+ * so a node refers to them by index instead of through ULuaValueObject pointers.
+ */
+USTRUCT(BlueprintType)
+struct FLuaFlatNode
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    ELuaType Type = ELuaType::Nil;
+
+    /** Key in the parent table (empty for array elements and the root). */
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    FString Key;
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    FString String;
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    double Number = 0.0;
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    bool Boolean = false;
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    FVector Vector = FVector::ZeroVector;
+
+    /** Index of the first child node (Array/Table), INDEX_NONE when empty. */
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    int32 FirstChild = INDEX_NONE;
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    int32 NumChildren = 0;
+};
+
+/**
+ * Lua value tree flattened into a single array (node 0 is the root).
+ * Marshaling into this form allocates no UObjects, so large tables do not add GC pressure;
+ * convert to FLuaDynValue with ToDynValue only where the UObject form is actually needed.
+ */
+USTRUCT(BlueprintType)
+struct LUARUNTIME_API FLuaFlatValue
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category="Lua")
+    TArray<FLuaFlatNode> Nodes;
+
+    static constexpr int32 RootIndex = 0;
+
+    bool IsNil() const { return Nodes.Num() == 0 || Nodes[RootIndex].Type == ELuaType::Nil; }
+    const FLuaFlatNode* GetNode(int32 NodeIndex) const { return Nodes.IsValidIndex(NodeIndex) ? &Nodes[NodeIndex] : nullptr; }
+
+    /** Child node index of an Array/Table node, INDEX_NONE when out of range. */
+    int32 GetChild(int32 NodeIndex, int32 ChildIndex) const;
+
+    /** Child node index of a Table node with the given key, INDEX_NONE when absent. */
+    int32 FindField(int32 NodeIndex, const FString& Key) const;
+
+    /** Build the UObject-backed representation of the subtree at NodeIndex. */
+    FLuaDynValue ToDynValue(int32 NodeIndex = RootIndex, UObject* Outer = nullptr) const;
+
+    static FLuaFlatValue FromDynValue(const FLuaDynValue& Value);
+
+private:
+    void AppendDynValue(int32 NodeIndex, const FLuaDynValue& Value);
+};
@@ -33,6 +33,9 @@ public:
     UFUNCTION(BlueprintPure, Category="Lua|Values")
     static FLuaDynValue MakeLuaString(const FString& s);
 
+    UFUNCTION(BlueprintPure, Category="Lua|Values")
+    static FLuaDynValue MakeLuaVector(const FVector& v);
+
     UFUNCTION(BlueprintPure, Category="Lua|Values")
     static FLuaDynValue MakeLuaArray(const TArray<FLuaDynValue>& Items);
 
@@ -51,6 +54,9 @@ public:
     UFUNCTION(BlueprintPure, Category="Lua|Values")
     static bool LuaValue_AsString(const FLuaDynValue& V, FString& Out, const FString& Default=TEXT(""));
 
+    UFUNCTION(BlueprintPure, Category="Lua|Values")
+    static bool LuaValue_AsVector(const FLuaDynValue& V, FVector& Out, FVector Default=FVector::ZeroVector);
+
     UFUNCTION(BlueprintPure, Category="Lua|Values")
     static bool LuaValue_IsArray(const FLuaDynValue& V) { return V.Type == ELuaType::Array; }
 
@@ -74,4 +80,46 @@ public:
 
     UFUNCTION(BlueprintPure, Category="Lua|Values", meta=(DisplayName="JSON → Lua Value"))
     static FLuaDynValue LuaValue_FromJson(const FString& Json);
+
+    // Flat values: nodes are addressed by index, the root is node 0
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static ELuaType LuaFlat_GetType(const FLuaFlatValue& V, int32 Node = 0);
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static int32 LuaFlat_Num(const FLuaFlatValue& V, int32 Node = 0);
+
+    /** Node index of the Index-th child of an Array/Table node, -1 when out of range. */
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static int32 LuaFlat_GetChild(const FLuaFlatValue& V, int32 Node, int32 Index) { return V.GetChild(Node, Index); }
+
+    /** Node index of a table field, -1 when absent. */
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static int32 LuaFlat_FindField(const FLuaFlatValue& V, int32 Node, const FString& Key) { return V.FindField(Node, Key); }
+
+    /** Follow a dotted field path (e.g. "stats.health") from the root, -1 when any part is missing. */
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static int32 LuaFlat_FindPath(const FLuaFlatValue& V, const FString& Path);
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static FString LuaFlat_GetKey(const FLuaFlatValue& V, int32 Node);
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static bool LuaFlat_AsBoolean(const FLuaFlatValue& V, int32 Node, bool& bOut, bool bDefault=false);
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static bool LuaFlat_AsNumber(const FLuaFlatValue& V, int32 Node, double& Out, double Default=0.0);
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static bool LuaFlat_AsString(const FLuaFlatValue& V, int32 Node, FString& Out, const FString& Default=TEXT(""));
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat")
+    static bool LuaFlat_AsVector(const FLuaFlatValue& V, int32 Node, FVector& Out, FVector Default=FVector::ZeroVector);
+
+    /** Build the UObject-backed value for a subtree (allocates one ULuaValueObject per child). */
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat", meta=(DisplayName="Lua Flat Value → Dyn Value"))
+    static FLuaDynValue LuaFlat_ToDynValue(const FLuaFlatValue& V, int32 Node = 0) { return V.ToDynValue(Node); }
+
+    UFUNCTION(BlueprintPure, Category="Lua|Values|Flat", meta=(DisplayName="Lua Dyn Value → Flat Value"))
+    static FLuaFlatValue LuaFlat_FromDynValue(const FLuaDynValue& V) { return FLuaFlatValue::FromDynValue(V); }
 };